@@ -0,0 +1,154 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/chunkedencoder.h>
+#include <vcl/graphics/recorder/recorder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// Wall-clock time of encoding a long recording offline
+//
+// Compares the serial 'Recorder' path against the 'ChunkedEncoder' using an
+// increasing number of concurrently encoded chunks. The synthetic input pans
+// a gradient across the image; the images are generated up-front, such that
+// reading the input does not limit either path. The first argument is the
+// duration of the input in seconds, the default covers ten minutes at 30 fps.
+namespace
+{
+	const int Width = 1920;
+	const int Height = 1080;
+	const int FrameRate = 30;
+
+	//! Number of distinct images cycled through
+	const int Distinct = 60;
+
+	class PanningSource : public FrameSource
+	{
+	public:
+		explicit PanningSource(uint64_t frames)
+		: _frames(frames)
+		, _Y(Distinct, std::vector<uint8_t>(Width * Height))
+		, _UV(Width * Height / 4, 128)
+		{
+			for (int f = 0; f < Distinct; f++)
+				for (int y = 0; y < Height; y++)
+					for (int x = 0; x < Width; x++)
+						_Y[f][y * Width + x] = static_cast<uint8_t>((x + y + 8 * f) & 0xff);
+		}
+
+		uint64_t frameCount() const override { return _frames; }
+
+		FrameView read(uint64_t index, std::vector<uint8_t>& /* buffer */) override
+		{
+			return FrameView::yuv420p(_Y[index % Distinct], Width, _UV, Width / 2, _UV, Width / 2, Width, Height);
+		}
+
+	private:
+		uint64_t _frames;
+		std::vector<std::vector<uint8_t>> _Y;
+		std::vector<uint8_t> _UV;
+	};
+
+	void BM_OfflineSerial(benchmark::State& state)
+	{
+		const std::string file_name = "bench_offline_serial.mp4";
+		PanningSource source{ static_cast<uint64_t>(state.range(0)) * FrameRate };
+
+		for (auto _ : state)
+		{
+			try
+			{
+				Recorder rec{ OutputFormat::Mp4, CodecType::H264, EncoderProfile::Balanced };
+				rec.open(file_name, Width, Height, FrameRate);
+				std::vector<uint8_t> buffer;
+				for (uint64_t i = 0; i < source.frameCount(); i++)
+				{
+					if (!rec.write(source.read(i, buffer)))
+						throw std::runtime_error("Writing frame failed");
+				}
+				rec.close();
+			}
+			catch (const std::exception& e)
+			{
+				state.SkipWithError(e.what());
+				return;
+			}
+			std::remove(file_name.c_str());
+		}
+
+		state.counters["fps"] = benchmark::Counter(static_cast<double>(source.frameCount() * state.iterations()), benchmark::Counter::kIsRate);
+	}
+
+	void BM_OfflineChunked(benchmark::State& state)
+	{
+		const std::string file_name = "bench_offline_chunked.mp4";
+		PanningSource source{ static_cast<uint64_t>(state.range(0)) * FrameRate };
+
+		ChunkOptions options;
+		options.chunk_frames = 10 * FrameRate;
+		options.threads = static_cast<unsigned int>(state.range(1));
+
+		for (auto _ : state)
+		{
+			try
+			{
+				ChunkedEncoder encoder{ OutputFormat::Mp4, CodecType::H264, EncoderProfile::Balanced };
+				encoder.setChunkOptions(options);
+				encoder.encode(source, file_name, Width, Height, FrameRate);
+			}
+			catch (const std::exception& e)
+			{
+				state.SkipWithError(e.what());
+				return;
+			}
+			std::remove(file_name.c_str());
+		}
+
+		state.counters["fps"] = benchmark::Counter(static_cast<double>(source.frameCount() * state.iterations()), benchmark::Counter::kIsRate);
+	}
+}
+
+BENCHMARK(BM_OfflineSerial)
+	->ArgName("seconds")
+	->Arg(600)
+	->Iterations(1)
+	->UseRealTime()
+	->Unit(benchmark::kSecond);
+BENCHMARK(BM_OfflineChunked)
+	->ArgNames({ "seconds", "threads" })
+	->Args({ 600, 8 })
+	->Args({ 600, 16 })
+	->Args({ 600, 32 })
+	->Args({ 600, 64 })
+	->Iterations(1)
+	->UseRealTime()
+	->Unit(benchmark::kSecond);
@@ -0,0 +1,136 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/recorder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// Latency of closing a large MP4 file
+//
+// With 'faststart' closing re-writes the complete file to move the index to
+// the front, fragmented files are closed by writing the last fragment. Only
+// the call to 'close' is measured. Lossless coding of noise produces the
+// output quickly, the output size in MB is given by the argument.
+namespace
+{
+	//! Number of distinct frames cycled through during a run
+	const int FrameCount = 8;
+
+	//! Frame size of the generated video
+	const int Width = 1920;
+	const int Height = 1080;
+
+	std::vector<uint8_t> noise(size_t size, std::mt19937& rng)
+	{
+		std::uniform_int_distribution<int> dist{ 0, 255 };
+		std::vector<uint8_t> data(size);
+		for (auto& v : data)
+			v = static_cast<uint8_t>(dist(rng));
+
+		return data;
+	}
+
+	void BM_Close(benchmark::State& state, Mp4Layout layout)
+	{
+		const int64_t target_bytes = state.range(0) * 1024 * 1024;
+		const std::string file_name = "bench_close.mp4";
+
+		// Noise cannot be compressed
+		std::mt19937 rng{ 42 };
+		std::vector<std::vector<uint8_t>> Y, U, V;
+		for (int f = 0; f < FrameCount; f++)
+		{
+			Y.emplace_back(noise(Width * Height, rng));
+			U.emplace_back(noise(Width * Height / 4, rng));
+			V.emplace_back(noise(Width * Height / 4, rng));
+		}
+
+		// The default quality of the profile. Lossless coding (crf 0) is not
+		// available in the main profile selected for libx264.
+		const EncoderSettings settings{ EncoderProfile::Realtime };
+
+		Mp4Options mp4;
+		mp4.layout = layout;
+
+		uint64_t output_bytes = 0;
+		for (auto _ : state)
+		{
+			std::unique_ptr<Recorder> rec;
+			try
+			{
+				rec = std::make_unique<Recorder>(OutputFormat::Mp4, CodecType::H264, settings);
+				rec->setMp4Options(mp4);
+				rec->open(file_name, Width, Height, 30);
+			}
+			catch (const std::exception& e)
+			{
+				state.SkipWithError(e.what());
+				return;
+			}
+
+			// Produce the output outside of the measurement
+			for (size_t f = 0; rec->stats().bytes_written < static_cast<uint64_t>(target_bytes); f = (f + 1) % FrameCount)
+			{
+				if (!rec->write(Y[f], U[f], V[f]))
+				{
+					state.SkipWithError("Writing frame failed");
+					return;
+				}
+			}
+
+			const auto start = std::chrono::steady_clock::now();
+			rec->close();
+			const auto end = std::chrono::steady_clock::now();
+			state.SetIterationTime(std::chrono::duration<double>(end - start).count());
+
+			output_bytes = rec->stats().bytes_written;
+			std::remove(file_name.c_str());
+		}
+
+		state.counters["output_bytes"] = static_cast<double>(output_bytes);
+	}
+}
+
+BENCHMARK_CAPTURE(BM_Close, faststart, Mp4Layout::Faststart)
+	->ArgName("MB")
+	->Arg(1024)
+	->Iterations(3)
+	->UseManualTime()
+	->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_Close, fragmented, Mp4Layout::Fragmented)
+	->ArgName("MB")
+	->Arg(1024)
+	->Iterations(3)
+	->UseManualTime()
+	->Unit(benchmark::kMillisecond);
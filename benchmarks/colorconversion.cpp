@@ -0,0 +1,89 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <random>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/colorconversion.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// Throughput of the conversion kernels in GB/s of source data
+// Arguments: instruction set, source format, destination format
+static void BM_ColorConversionKernel(benchmark::State& state)
+{
+	const auto level = static_cast<SimdLevel>(state.range(0));
+	const auto src_fmt = static_cast<PixelFormat>(state.range(1));
+	const auto dst_fmt = static_cast<PixelFormat>(state.range(2));
+	if (level > detectSimdLevel())
+	{
+		state.SkipWithError("Instruction set not supported");
+		return;
+	}
+
+	const int w = 1920;
+	const int h = 1080;
+	const int bpp = src_fmt == PixelFormat::Bgra ? 4 : 3;
+
+	std::mt19937 rng{ 5489u };
+	std::vector<uint8_t> src(w * h * bpp);
+	for (auto& v : src)
+		v = static_cast<uint8_t>(rng());
+	std::vector<uint8_t> y(w * h), u(dst_fmt == PixelFormat::Nv12 ? w * h / 2 : w * h / 4), v(w * h / 4);
+
+	ConversionParams params;
+	params.src_format = src_fmt;
+	params.src = src.data();
+	params.src_stride = w * bpp;
+	params.width = w;
+	params.height = h;
+	params.dst_format = dst_fmt;
+	params.dst[0] = y.data();
+	params.dst[1] = u.data();
+	params.dst[2] = dst_fmt == PixelFormat::Nv12 ? nullptr : v.data();
+	params.dst_stride[0] = w;
+	params.dst_stride[1] = dst_fmt == PixelFormat::Nv12 ? w : w / 2;
+	params.dst_stride[2] = dst_fmt == PixelFormat::Nv12 ? 0 : w / 2;
+	params.matrix = ColorMatrix::Bt709;
+
+	for (auto _ : state)
+	{
+		convertRows(level, params, 0, h);
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * w * h * bpp);
+}
+
+static void ColorConversionArguments(benchmark::internal::Benchmark* b)
+{
+	for (auto level : { SimdLevel::Scalar, SimdLevel::Sse41, SimdLevel::Avx2 })
+		for (auto src : { PixelFormat::Rgb24, PixelFormat::Bgr24, PixelFormat::Bgra })
+			for (auto dst : { PixelFormat::Yuv420P, PixelFormat::Nv12 })
+				b->Args({ static_cast<int>(level), static_cast<int>(src), static_cast<int>(dst) });
+	b->ArgNames({ "simd", "src", "dst" });
+}
+BENCHMARK(BM_ColorConversionKernel)->Apply(ColorConversionArguments)->Unit(benchmark::kMicrosecond);
@@ -0,0 +1,191 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <array>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/frameconverter.h>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	std::vector<std::array<uint8_t, 3>> createTestImage(int w, int h)
+	{
+		std::vector<std::array<uint8_t, 3>> image(w * h);
+		for (int y = 0; y < h; y++)
+			for (int x = 0; x < w; x++)
+				image[y * w + x] = { static_cast<uint8_t>(x), static_cast<uint8_t>(y), static_cast<uint8_t>(x + y) };
+
+		return image;
+	}
+
+	std::unique_ptr<AVFrame, void(*)(AVFrame*)> createFrame(AVPixelFormat fmt, int w, int h)
+	{
+		AVFrame* frame = av_frame_alloc();
+		frame->format = fmt;
+		frame->width = w;
+		frame->height = h;
+		av_frame_get_buffer(frame, 32);
+
+		return { frame, [](AVFrame* f) { av_frame_free(&f); } };
+	}
+}
+
+// Conversion as implemented before the converter was introduced:
+// Context and destination buffer are recreated for every frame.
+static void BM_ConvertRgbPerFrameContext(benchmark::State& state)
+{
+	const int w = static_cast<int>(state.range(0));
+	const int h = static_cast<int>(state.range(1));
+	const auto rgb = createTestImage(w, h);
+
+	const uint8_t* bgr24[4] = { rgb.data()->data(), nullptr, nullptr, nullptr };
+	const int bgr24_stride[4] = { 3 * w, 0, 0, 0 };
+
+	for (auto _ : state)
+	{
+		SwsContext* sws_ctx = sws_getContext(w, h, AV_PIX_FMT_BGR24, w, h, AV_PIX_FMT_YUV420P, SWS_BICUBIC, nullptr, nullptr, nullptr);
+		auto buffer = reinterpret_cast<uint8_t*>(malloc(3 * w * h));
+		uint8_t* yuv420p[4] = { buffer, buffer + w*h, buffer + w*h + w*h/4, nullptr };
+		int yuv420p_stride[4] = { w, w/2, w/2, 0 };
+		sws_scale(sws_ctx, bgr24, bgr24_stride, 0, h, yuv420p, yuv420p_stride);
+		benchmark::DoNotOptimize(buffer);
+
+		free(buffer);
+		sws_freeContext(sws_ctx);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * 3 * w * h);
+}
+BENCHMARK(BM_ConvertRgbPerFrameContext)->Args({1280, 720})->Args({1920, 1080})->Unit(benchmark::kMicrosecond);
+
+// Conversion by the converter writing into a persistent frame. Images
+// keeping their size are converted by the vectorized kernels.
+static void BM_ConvertRgbConverter(benchmark::State& state)
+{
+	const int w = static_cast<int>(state.range(0));
+	const int h = static_cast<int>(state.range(1));
+	const auto rgb = createTestImage(w, h);
+	auto frame = createFrame(AV_PIX_FMT_YUV420P, w, h);
+
+	const uint8_t* bgr24[4] = { rgb.data()->data(), nullptr, nullptr, nullptr };
+	const int bgr24_stride[4] = { 3 * w, 0, 0, 0 };
+
+	FrameConverter converter;
+	for (auto _ : state)
+	{
+		converter.convert(bgr24, bgr24_stride, AV_PIX_FMT_BGR24, w, h, frame.get());
+		benchmark::DoNotOptimize(frame->data[0]);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * 3 * w * h);
+}
+BENCHMARK(BM_ConvertRgbConverter)->Args({1280, 720})->Args({1920, 1080})->Unit(benchmark::kMicrosecond);
+
+// Scaling with a context created for every frame
+// Arguments: source width, source height, destination width, destination height
+static void BM_ScaleRgbPerFrameContext(benchmark::State& state)
+{
+	const int w = static_cast<int>(state.range(0));
+	const int h = static_cast<int>(state.range(1));
+	const auto rgb = createTestImage(w, h);
+	auto frame = createFrame(AV_PIX_FMT_YUV420P, static_cast<int>(state.range(2)), static_cast<int>(state.range(3)));
+
+	const uint8_t* bgr24[4] = { rgb.data()->data(), nullptr, nullptr, nullptr };
+	const int bgr24_stride[4] = { 3 * w, 0, 0, 0 };
+
+	for (auto _ : state)
+	{
+		SwsContext* sws_ctx = sws_getContext(w, h, AV_PIX_FMT_BGR24, frame->width, frame->height, AV_PIX_FMT_YUV420P, SWS_BICUBIC, nullptr, nullptr, nullptr);
+		sws_scale(sws_ctx, bgr24, bgr24_stride, 0, h, frame->data, frame->linesize);
+		benchmark::DoNotOptimize(frame->data[0]);
+		sws_freeContext(sws_ctx);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * 3 * w * h);
+}
+BENCHMARK(BM_ScaleRgbPerFrameContext)->Args({1920, 1080, 1280, 720})->Args({3840, 2160, 1920, 1080})->Unit(benchmark::kMicrosecond);
+
+// Scaling reusing the swscale context cached by the converter
+// Arguments: source width, source height, destination width, destination height
+static void BM_ScaleRgbCachedContext(benchmark::State& state)
+{
+	const int w = static_cast<int>(state.range(0));
+	const int h = static_cast<int>(state.range(1));
+	const auto rgb = createTestImage(w, h);
+	auto frame = createFrame(AV_PIX_FMT_YUV420P, static_cast<int>(state.range(2)), static_cast<int>(state.range(3)));
+
+	const uint8_t* bgr24[4] = { rgb.data()->data(), nullptr, nullptr, nullptr };
+	const int bgr24_stride[4] = { 3 * w, 0, 0, 0 };
+
+	FrameConverter converter;
+	for (auto _ : state)
+	{
+		converter.convert(bgr24, bgr24_stride, AV_PIX_FMT_BGR24, w, h, frame.get());
+		benchmark::DoNotOptimize(frame->data[0]);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * 3 * w * h);
+}
+BENCHMARK(BM_ScaleRgbCachedContext)->Args({1920, 1080, 1280, 720})->Args({3840, 2160, 1920, 1080})->Unit(benchmark::kMicrosecond);
+
+// Scaling of the slice-parallel conversion of BGRA images into NV12
+// Arguments: width, height, number of slices
+static void BM_ConvertBgraSliced(benchmark::State& state)
+{
+	const int w = static_cast<int>(state.range(0));
+	const int h = static_cast<int>(state.range(1));
+	std::vector<uint8_t> bgra(4 * w * h, 128);
+	auto frame = createFrame(AV_PIX_FMT_NV12, w, h);
+
+	const uint8_t* src[4] = { bgra.data(), nullptr, nullptr, nullptr };
+	const int src_stride[4] = { 4 * w, 0, 0, 0 };
+
+	FrameConverter converter;
+	converter.setSliceCount(static_cast<unsigned int>(state.range(2)));
+	for (auto _ : state)
+	{
+		converter.convert(src, src_stride, AV_PIX_FMT_BGRA, w, h, frame.get());
+		benchmark::DoNotOptimize(frame->data[0]);
+	}
+	state.SetItemsProcessed(state.iterations());
+	state.SetBytesProcessed(state.iterations() * 4 * w * h);
+}
+BENCHMARK(BM_ConvertBgraSliced)
+	->ArgNames({ "w", "h", "slices" })
+	->ArgsProduct({ { 1920 }, { 1080 }, { 1, 2, 4, 8 } })
+	->ArgsProduct({ { 3840 }, { 2160 }, { 1, 2, 4, 8 } })
+	->Unit(benchmark::kMicrosecond)
+	->UseRealTime();
@@ -0,0 +1,112 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/scheduler.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// Many small concurrent recordings
+//
+// Each recording uses the asynchronous pipeline and is fed round-robin by
+// the benchmark thread. With dedicated threads every recorder starts its
+// own pipeline and encoder threads, the shared variant executes all
+// recorders on 'Scheduler::global()'. The argument is the number of
+// concurrent recordings.
+namespace
+{
+	const int Width = 320;
+	const int Height = 240;
+	const int Frames = 100;
+
+	void BM_ConcurrentRecordings(benchmark::State& state, bool shared)
+	{
+		const int recordings = static_cast<int>(state.range(0));
+
+		std::vector<uint8_t> Y(Width * Height, 128);
+		std::vector<uint8_t> U(Width * Height / 4, 64);
+		std::vector<uint8_t> V(Width * Height / 4, 192);
+
+		for (auto _ : state)
+		{
+			std::vector<std::unique_ptr<Recorder>> recorders;
+			try
+			{
+				for (int r = 0; r < recordings; r++)
+				{
+					auto rec = std::make_unique<Recorder>(OutputFormat::Mkv, CodecType::H264, EncoderProfile::Realtime);
+					rec->setAsyncEncoding(true);
+					if (shared)
+						rec->setScheduler(Scheduler::global());
+					rec->open(std::make_shared<NullSink>(), Width, Height, 30);
+					recorders.emplace_back(std::move(rec));
+				}
+			}
+			catch (const std::exception& e)
+			{
+				state.SkipWithError(e.what());
+				return;
+			}
+
+			for (int f = 0; f < Frames; f++)
+			{
+				// Move a bright bar through the image
+				std::fill(Y.begin() + (f % Height) * Width, Y.begin() + (f % Height + 1) * Width, static_cast<uint8_t>(255));
+				for (auto& rec : recorders)
+				{
+					if (!rec->write(Y, U, V))
+					{
+						state.SkipWithError("Writing frame failed");
+						return;
+					}
+				}
+			}
+
+			for (auto& rec : recorders)
+				rec->close();
+		}
+
+		state.counters["fps"] = benchmark::Counter(static_cast<double>(recordings * Frames * state.iterations()), benchmark::Counter::kIsRate);
+		if (shared)
+			state.counters["steals"] = static_cast<double>(Scheduler::global()->stats().steals);
+	}
+}
+
+BENCHMARK_CAPTURE(BM_ConcurrentRecordings, dedicated, false)
+	->ArgName("recordings")
+	->Arg(100)
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_ConcurrentRecordings, shared, true)
+	->ArgName("recordings")
+	->Arg(100)
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
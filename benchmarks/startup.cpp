@@ -0,0 +1,74 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <memory>
+#include <stdexcept>
+
+// VCL
+#include <vcl/graphics/recorder/encoderregistry.h>
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// Latency until a recorder is ready to accept images
+//
+// Measures creating and opening a recorder selecting the preferred H264
+// encoder. The 'probe' variant clears the encoder registry before every
+// iteration, thus includes trial-opening all candidate encoders as done by
+// the first recorder of a process. The 'cached' variant reuses the results.
+namespace
+{
+	void BM_RecorderStartup(benchmark::State& state, bool probe)
+	{
+		auto& registry = EncoderRegistry::instance();
+		const auto probes = registry.probeCount();
+
+		for (auto _ : state)
+		{
+			if (probe)
+				registry.reset();
+
+			try
+			{
+				Recorder rec{ OutputFormat::Mkv, CodecType::H264, EncoderProfile::Realtime };
+				rec.open(std::make_shared<NullSink>(), 640, 360, 30);
+				rec.close();
+			}
+			catch (const std::exception& e)
+			{
+				state.SkipWithError(e.what());
+				return;
+			}
+		}
+
+		state.counters["probes"] = benchmark::Counter(static_cast<double>(registry.probeCount() - probes), benchmark::Counter::kAvgIterations);
+	}
+}
+
+BENCHMARK_CAPTURE(BM_RecorderStartup, probe, true)
+	->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_RecorderStartup, cached, false)
+	->Unit(benchmark::kMillisecond);
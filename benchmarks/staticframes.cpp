@@ -0,0 +1,129 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <array>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// CPU time of recording a mostly static desktop
+//
+// The synthetic desktop consists of a few uniformly coloured windows.
+// A small region, e.g. a blinking cursor or a clock, changes once every
+// 'period' frames. Compare the process CPU time with and without the
+// static frame detection; the encoder threads are included.
+namespace
+{
+	const int Width = 1920;
+	const int Height = 1080;
+
+	//! Desktop with windows of different colours
+	std::vector<std::array<uint8_t, 4>> createDesktop()
+	{
+		std::vector<std::array<uint8_t, 4>> desktop(Width * Height, { 96, 64, 32, 255 });
+		const std::array<std::array<int, 4>, 3> windows =
+		{{
+			{ 100, 100, 900, 700 },
+			{ 600, 300, 1700, 900 },
+			{ 0, Height - 40, Width, Height },
+		}};
+		int colour = 0;
+		for (const auto& w : windows)
+		{
+			colour += 70;
+			for (int y = w[1]; y < w[3]; y++)
+				for (int x = w[0]; x < w[2]; x++)
+					desktop[y * Width + x] = { static_cast<uint8_t>(colour), static_cast<uint8_t>(255 - colour), 200, 255 };
+		}
+
+		return desktop;
+	}
+
+	void BM_StaticDesktop(benchmark::State& state, bool detect)
+	{
+		const int period = static_cast<int>(state.range(0));
+		auto desktop = createDesktop();
+
+		Recorder rec{ OutputFormat::Mkv, CodecType::H264, EncoderProfile::Realtime };
+		rec.setStaticFrameDetection(detect);
+		try
+		{
+			rec.open(std::make_shared<NullSink>(), Width, Height, 30);
+		}
+		catch (const std::exception& e)
+		{
+			state.SkipWithError(e.what());
+			return;
+		}
+
+		int frame = 0;
+		for (auto _ : state)
+		{
+			// Toggle a cursor sized block
+			if (frame % period == 0)
+			{
+				const uint8_t value = static_cast<uint8_t>((frame / period) % 2 ? 255 : 0);
+				for (int y = 500; y < 516; y++)
+					for (int x = 1000; x < 1002; x++)
+						desktop[y * Width + x] = { value, value, value, 255 };
+			}
+			frame++;
+
+			if (!rec.write(desktop, Width, Height))
+			{
+				state.SkipWithError("Writing frame failed");
+				break;
+			}
+		}
+		rec.close();
+
+		const auto stats = rec.stats();
+		state.counters["skipped"] = static_cast<double>(stats.skipped_frames);
+		state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+	}
+}
+
+BENCHMARK_CAPTURE(BM_StaticDesktop, encode_all, false)
+	->ArgName("period")
+	->Arg(1)
+	->Arg(10)
+	->Arg(60)
+	->MeasureProcessCPUTime()
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_StaticDesktop, skip_static, true)
+	->ArgName("period")
+	->Arg(1)
+	->Arg(10)
+	->Arg(60)
+	->MeasureProcessCPUTime()
+	->UseRealTime()
+	->Unit(benchmark::kMillisecond);
@@ -0,0 +1,232 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <benchmark/benchmark.h>
+
+// C++ standard library
+#include <array>
+#include <cstdio>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// End-to-end throughput of the write paths of the recorder
+//
+// Every combination of input layout, resolution, container, available
+// encoder and output target is registered. The null sink removes the disk
+// from the measurement, the file target includes it. Use
+//   --benchmark_format=json --benchmark_out=write.json
+// to store the results for comparison between runs.
+namespace
+{
+	enum class WritePath
+	{
+		Yuv420P,
+		Nv12,
+		Rgb24,
+		Bgra
+	};
+
+	enum class Target
+	{
+		Null,
+		File
+	};
+
+	//! Number of distinct frames cycled through during a run
+	const int FrameCount = 8;
+
+	//! Synthetic input frames of a given layout
+	//! The content moves between frames to prevent the encoder from
+	//! skipping the image data entirely.
+	struct InputFrames
+	{
+		InputFrames(WritePath path, int w, int h)
+		: width(w), height(h)
+		{
+			const int planes = (path == WritePath::Yuv420P) ? 3 : (path == WritePath::Nv12) ? 2 : 1;
+			for (int f = 0; f < FrameCount; f++)
+			{
+				std::array<std::vector<uint8_t>, 3> frame;
+				switch (path)
+				{
+				case WritePath::Yuv420P:
+					frame[0] = gradient(w, h, 1, f);
+					frame[1] = gradient(w / 2, h / 2, 1, 2 * f);
+					frame[2] = gradient(w / 2, h / 2, 1, 3 * f);
+					break;
+				case WritePath::Nv12:
+					frame[0] = gradient(w, h, 1, f);
+					frame[1] = gradient(w / 2, h / 2, 2, 2 * f);
+					break;
+				case WritePath::Rgb24:
+					frame[0] = gradient(w, h, 3, f);
+					break;
+				case WritePath::Bgra:
+					frame[0] = gradient(w, h, 4, f);
+					break;
+				}
+				frames.emplace_back(std::move(frame));
+			}
+			bytesPerFrame = 0;
+			for (int p = 0; p < planes; p++)
+				bytesPerFrame += frames[0][p].size();
+		}
+
+		static std::vector<uint8_t> gradient(int w, int h, int channels, int offset)
+		{
+			std::vector<uint8_t> data(static_cast<size_t>(w) * h * channels);
+			for (int y = 0; y < h; y++)
+				for (int x = 0; x < w; x++)
+					for (int c = 0; c < channels; c++)
+						data[(static_cast<size_t>(y) * w + x) * channels + c] = static_cast<uint8_t>(x + 2 * y + 4 * offset + 64 * c);
+
+			return data;
+		}
+
+		int width;
+		int height;
+		size_t bytesPerFrame;
+		std::vector<std::array<std::vector<uint8_t>, 3>> frames;
+	};
+
+	bool write(Recorder& rec, WritePath path, const InputFrames& input, const std::array<std::vector<uint8_t>, 3>& frame)
+	{
+		const unsigned int w = static_cast<unsigned int>(input.width);
+		const unsigned int h = static_cast<unsigned int>(input.height);
+		switch (path)
+		{
+		case WritePath::Yuv420P:
+			return rec.write(frame[0], frame[1], frame[2]);
+		case WritePath::Nv12:
+			return rec.write(frame[0], { reinterpret_cast<const std::array<uint8_t, 2>*>(frame[1].data()), static_cast<std::ptrdiff_t>(frame[1].size() / 2) });
+		case WritePath::Rgb24:
+			return rec.write({ reinterpret_cast<const std::array<uint8_t, 3>*>(frame[0].data()), static_cast<std::ptrdiff_t>(frame[0].size() / 3) }, w, h);
+		case WritePath::Bgra:
+			return rec.write({ reinterpret_cast<const std::array<uint8_t, 4>*>(frame[0].data()), static_cast<std::ptrdiff_t>(frame[0].size() / 4) }, w, h);
+		}
+		return false;
+	}
+
+	const char* extension(OutputFormat fmt)
+	{
+		switch (fmt)
+		{
+		case OutputFormat::Avi: return "avi";
+		case OutputFormat::Mkv: return "mkv";
+		case OutputFormat::Mp4: return "mp4";
+		}
+		return "bin";
+	}
+
+	void BM_Write(benchmark::State& state, WritePath path, OutputFormat fmt, std::string encoder, Target target)
+	{
+		const int w = static_cast<int>(state.range(0));
+		const int h = static_cast<int>(state.range(1));
+		const InputFrames input{ path, w, h };
+		const std::string file_name = std::string{ "bench_write." } + extension(fmt);
+
+		auto sink = std::make_shared<NullSink>();
+		std::unique_ptr<Recorder> rec;
+		try
+		{
+			rec = std::make_unique<Recorder>(fmt, CodecType::H264, encoder);
+			if (target == Target::Null)
+				rec->open(sink, w, h, 30);
+			else
+				rec->open(file_name, w, h, 30);
+		}
+		catch (const std::exception& e)
+		{
+			state.SkipWithError(e.what());
+			return;
+		}
+
+		size_t frame_idx = 0;
+		for (auto _ : state)
+		{
+			if (!write(*rec, path, input, input.frames[frame_idx]))
+			{
+				state.SkipWithError("Writing frame failed");
+				break;
+			}
+			frame_idx = (frame_idx + 1) % input.frames.size();
+		}
+
+		// Frames still held by the encoder are flushed outside of the
+		// measurement. Their share vanishes with the number of iterations.
+		rec->close();
+		if (target == Target::File)
+			std::remove(file_name.c_str());
+		else
+			state.counters["output_bytes"] = static_cast<double>(sink->bytesWritten());
+
+		state.SetItemsProcessed(state.iterations());
+		state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(input.bytesPerFrame));
+		state.counters["fps"] = benchmark::Counter(static_cast<double>(state.iterations()), benchmark::Counter::kIsRate);
+		state.counters["ns_per_frame"] = benchmark::Counter(static_cast<double>(state.iterations()) * 1e-9, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+	}
+
+	//! Register the benchmarks for all available encoders
+	//! The encoders are only known at runtime, thus the benchmarks cannot
+	//! be registered using the 'BENCHMARK' macro.
+	const bool WriteBenchmarksRegistered = []()
+	{
+		const std::array<std::pair<WritePath, const char*>, 4> paths =
+		{{
+			{ WritePath::Yuv420P, "yuv420p" },
+			{ WritePath::Nv12, "nv12" },
+			{ WritePath::Rgb24, "rgb24" },
+			{ WritePath::Bgra, "bgra" },
+		}};
+		const std::array<OutputFormat, 3> formats = { OutputFormat::Avi, OutputFormat::Mkv, OutputFormat::Mp4 };
+		const std::array<std::pair<Target, const char*>, 2> targets =
+		{{
+			{ Target::Null, "null" },
+			{ Target::File, "file" },
+		}};
+
+		for (const auto& encoder : Recorder::availableEncoders(CodecType::H264))
+			for (const auto fmt : formats)
+				for (const auto& target : targets)
+					for (const auto& path : paths)
+					{
+						const std::string name = std::string{ "BM_Write/" } + path.second + "/" + extension(fmt) + "/" + encoder + "/" + target.second;
+						benchmark::RegisterBenchmark(name.c_str(), BM_Write, path.first, fmt, encoder, target.first)
+							->ArgNames({ "w", "h" })
+							->Args({ 1280, 720 })
+							->Args({ 1920, 1080 })
+							->Args({ 3840, 2160 })
+							->Unit(benchmark::kMillisecond)
+							->UseRealTime();
+					}
+
+		return true;
+	}();
+}
@@ -201,6 +201,7 @@ void startRecording(int width, int height)
 	screen = std::make_unique<Screen>(POINT{0, 0}, POINT{1920, 1080});
 
 	recorder = std::make_unique<Recorder>(OutputFormat::Mp4, CodecType::H264);
+	recorder->setAsyncEncoding(true);
 	recorder->open("screen_capture.mp4", width, height, 25);
 	recording_timer.start(40, []()
 	{
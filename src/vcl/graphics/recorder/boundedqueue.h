@@ -0,0 +1,193 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Fixed capacity, blocking FIFO connecting the stages of the
+	//! asynchronous encoding pipeline.
+	//! The storage is allocated once at construction, thus pushing and
+	//! popping does not allocate memory.
+	template<typename T>
+	class BoundedQueue
+	{
+	public:
+		explicit BoundedQueue(size_t capacity)
+		: _items(capacity > 0 ? capacity : 1)
+		{
+		}
+
+		//! Append an item to the queue. Blocks while the queue is full.
+		//! \returns false if the queue was closed and the item was not added
+		bool push(T item)
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+			_notFull.wait(lock, [this]() { return _closed || _count < _items.size(); });
+			if (_closed)
+				return false;
+
+			_items[(_head + _count) % _items.size()] = std::move(item);
+			_count++;
+
+			lock.unlock();
+			_notEmpty.notify_one();
+			return true;
+		}
+
+		//! Append an item to the queue without blocking
+		//! \returns false if the queue was full or closed. The item is not moved in that case.
+		bool tryPush(T& item)
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+			if (_closed || _count == _items.size())
+				return false;
+
+			_items[(_head + _count) % _items.size()] = std::move(item);
+			_count++;
+
+			lock.unlock();
+			_notEmpty.notify_one();
+			return true;
+		}
+
+		//! Append an item to the queue, removing the oldest item if the queue is full
+		//! \param evicted Receives the removed item
+		//! \param was_evicted Set if an item was removed
+		//! \returns false if the queue was closed. The item is not moved in that case.
+		bool pushEvict(T& item, T& evicted, bool& was_evicted)
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+			was_evicted = false;
+			if (_closed)
+				return false;
+
+			if (_count == _items.size())
+			{
+				evicted = std::move(_items[_head]);
+				_head = (_head + 1) % _items.size();
+				_count--;
+				was_evicted = true;
+			}
+
+			_items[(_head + _count) % _items.size()] = std::move(item);
+			_count++;
+
+			lock.unlock();
+			_notEmpty.notify_one();
+			return true;
+		}
+
+		//! Remove the oldest item from the queue. Blocks while the queue is empty.
+		//! \returns false if the queue was closed and all items were consumed
+		bool pop(T& item)
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+			_notEmpty.wait(lock, [this]() { return _closed || _count > 0; });
+			if (_count == 0)
+				return false;
+
+			item = std::move(_items[_head]);
+			_head = (_head + 1) % _items.size();
+			_count--;
+
+			lock.unlock();
+			_notFull.notify_one();
+			return true;
+		}
+
+		//! Remove the oldest item from the queue without blocking
+		//! \returns false if the queue was empty
+		bool tryPop(T& item)
+		{
+			std::unique_lock<std::mutex> lock{ _mutex };
+			if (_count == 0)
+				return false;
+
+			item = std::move(_items[_head]);
+			_head = (_head + 1) % _items.size();
+			_count--;
+
+			lock.unlock();
+			_notFull.notify_one();
+			return true;
+		}
+
+		//! Stop accepting new items. Pending items can still be popped.
+		void close()
+		{
+			{
+				std::lock_guard<std::mutex> lock{ _mutex };
+				_closed = true;
+			}
+			_notEmpty.notify_all();
+			_notFull.notify_all();
+		}
+
+		//! Re-open a closed and drained queue
+		void reset()
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_head = 0;
+			_count = 0;
+			_closed = false;
+		}
+
+		size_t size() const
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			return _count;
+		}
+
+		size_t capacity() const
+		{
+			return _items.size();
+		}
+
+	private:
+		//! Ring-buffer storing the queued items
+		std::vector<T> _items;
+
+		//! Index of the oldest item
+		size_t _head{ 0 };
+
+		//! Number of queued items
+		size_t _count{ 0 };
+
+		//! Queue does not accept new items anymore
+		bool _closed{ false };
+
+		//! Protect the queue state
+		mutable std::mutex _mutex;
+
+		//! Signal consumers
+		std::condition_variable _notEmpty;
+
+		//! Signal producers
+		std::condition_variable _notFull;
+	};
+}}}
@@ -0,0 +1,180 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "chunkedencoder.h"
+
+// VCL
+#include "muxer.h"
+#include "threadpool.h"
+
+// C++ standard library
+#include <algorithm>
+#include <exception>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	ChunkedEncoder::ChunkedEncoder(OutputFormat out_fmt, CodecType codec, EncoderSettings settings)
+	: _outputFormat(out_fmt)
+	, _codec(codec)
+	, _settings(std::move(settings))
+	{
+		// Validate the configuration before starting any work
+		Recorder probe{ out_fmt, codec, _settings };
+	}
+
+	void ChunkedEncoder::setChunkOptions(ChunkOptions options)
+	{
+		if (options.chunk_frames == 0)
+			throw std::domain_error("Chunks need to contain at least one image");
+
+		_options = options;
+	}
+
+	uint64_t ChunkedEncoder::encode(FrameSource& source, absl::string_view url, unsigned int width, unsigned int height, unsigned int frame_rate)
+	{
+		const uint64_t frames = source.frameCount();
+		if (frames == 0)
+			throw std::domain_error("Source does not contain any image");
+
+		const uint64_t chunk_frames = _options.chunk_frames;
+		const uint64_t chunks = (frames + chunk_frames - 1) / chunk_frames;
+		const unsigned int threads = _options.threads > 0 ? _options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+		// The calling thread encodes chunks in addition to the workers
+		ThreadPool pool{ threads - 1 };
+
+		Muxer muxer{ _outputFormat };
+		uint64_t written = 0;
+		std::vector<AVPacket*> packets;
+
+		// Encode the chunks in batches, such that only the packets of a
+		// single batch are kept in memory
+		for (uint64_t batch = 0; batch < chunks; batch += threads)
+		{
+			const unsigned int count = static_cast<unsigned int>(std::min<uint64_t>(threads, chunks - batch));
+			std::vector<std::unique_ptr<Recorder>> recorders(count);
+			std::vector<std::exception_ptr> errors(count);
+			pool.parallelFor(count, [&](unsigned int c)
+			{
+				const uint64_t first = (batch + c) * chunk_frames;
+				try
+				{
+					recorders[c] = std::make_unique<Recorder>(_outputFormat, _codec, _settings);
+					encodeChunk(source, *recorders[c], first, std::min(chunk_frames, frames - first), width, height, frame_rate);
+				}
+				catch (...)
+				{
+					errors[c] = std::current_exception();
+				}
+			});
+			for (const auto& error : errors)
+			{
+				if (error)
+					std::rethrow_exception(error);
+			}
+
+			// Append the chunks in order
+			for (unsigned int c = 0; c < count; c++)
+			{
+				const Recorder& rec = *recorders[c];
+
+				const TimeBase rec_time_base = rec.timeBase();
+				const AVRational time_base{ rec_time_base.num, rec_time_base.den };
+
+				// All chunks use identical encoder settings, thus share the stream parameters
+				if (!muxer.isOpen())
+				{
+					AVCodecParameters* par = avcodec_parameters_alloc();
+					if (!par)
+						throw std::runtime_error("Allocating codec parameters failed");
+					try
+					{
+						rec.streamParameters(par);
+						muxer.open(url, par, time_base, _mp4Options);
+					}
+					catch (...)
+					{
+						avcodec_parameters_free(&par);
+						throw;
+					}
+					avcodec_parameters_free(&par);
+				}
+
+				// Each chunk starts at timestamp 0. Shift it to the position
+				// of its first image, given in frame intervals.
+				const int64_t offset = av_rescale_q(static_cast<int64_t>((batch + c) * chunk_frames), { 1, static_cast<int>(frame_rate) }, time_base);
+
+				rec.replayPackets(packets);
+				bool failed = false;
+				for (AVPacket*& pkt : packets)
+				{
+					pkt->pts += offset;
+					pkt->dts += offset;
+					if (!failed && muxer.write(pkt, time_base))
+						written++;
+					else
+						failed = true;
+					av_packet_free(&pkt);
+				}
+				packets.clear();
+
+				if (failed)
+					throw std::runtime_error("Writing chunk failed");
+			}
+		}
+		if (!muxer.close())
+			throw std::runtime_error("Closing output failed");
+
+		return written;
+	}
+
+	void ChunkedEncoder::encodeChunk(FrameSource& source, Recorder& rec, uint64_t first, uint64_t count, unsigned int width, unsigned int height, unsigned int frame_rate)
+	{
+		// Chunks provide the parallelism, thus each encoder uses a single thread
+		EncoderThreads threads;
+		threads.count = 1;
+		rec.setEncoderThreads(threads);
+
+		// Keep all packets of the chunk in memory
+		ReplayOptions replay;
+		replay.max_bytes = std::numeric_limits<uint64_t>::max();
+		rec.open(replay, width, height, frame_rate);
+
+		std::vector<uint8_t> buffer;
+		for (uint64_t i = first; i < first + count; i++)
+		{
+			if (!rec.write(source.read(i, buffer)))
+				throw std::runtime_error("Encoding chunk failed");
+		}
+		if (!rec.close())
+			throw std::runtime_error("Encoding chunk failed");
+	}
+}}}
@@ -0,0 +1,121 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// Abseil
+#include <absl/strings/string_view.h>
+
+// C++ standard library
+#include <cstdint>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/encodersettings.h>
+#include <vcl/graphics/recorder/frameview.h>
+#include <vcl/graphics/recorder/mp4options.h>
+#include <vcl/graphics/recorder/recorder.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Random access to the images of an offline recording
+	class VCL_GRAPHICS_RECORDER_API FrameSource
+	{
+	public:
+		virtual ~FrameSource() = default;
+
+		//! \returns the number of images
+		virtual uint64_t frameCount() const = 0;
+
+		//! Provide an image
+		//! Called concurrently from multiple threads, each with its own buffer.
+		//! \param index Number of the image
+		//! \param buffer Storage of the calling thread which can receive the image
+		//! \returns a view onto the image. Needs to stay valid until the next
+		//!          call using the same buffer.
+		virtual FrameView read(uint64_t index, std::vector<uint8_t>& buffer) = 0;
+	};
+
+	//! Configuration of the chunked encoding
+	struct ChunkOptions
+	{
+		//! Number of images per chunk. Each chunk starts with a keyframe.
+		unsigned int chunk_frames{300};
+
+		//! Number of chunks encoded concurrently. 0 selects the number of hardware threads.
+		unsigned int threads{0};
+	};
+
+	//! Encodes a complete recording in parallel
+	//! The images are split into chunks of consecutive images. Each chunk is
+	//! encoded by an independent encoder, thus starts with a keyframe and only
+	//! references images of the same chunk. The packets of the chunks are
+	//! written in order into a single container with continuous timestamps.
+	class VCL_GRAPHICS_RECORDER_API ChunkedEncoder
+	{
+	public:
+		//! \param out_fmt Container format
+		//! \param codec Codec used to compress the video
+		//! \param settings Encoder settings applied to every chunk
+		//! \throws std::domain_error if the container cannot store the codec
+		ChunkedEncoder(OutputFormat out_fmt, CodecType codec, EncoderSettings settings = {});
+
+		//! Set the options of the chunking
+		//! \throws std::domain_error if a chunk would not contain any image
+		void setChunkOptions(ChunkOptions options);
+		const ChunkOptions& chunkOptions() const { return _options; }
+
+		//! Configure the layout of MP4 output
+		void setMp4Options(Mp4Options options) { _mp4Options = options; }
+		const Mp4Options& mp4Options() const { return _mp4Options; }
+
+		//! Encode all images of a source into a file
+		//! \param source Images to encode
+		//! \param url Path of the file to create
+		//! \param width Width of the video
+		//! \param height Height of the video
+		//! \param frame_rate Frames per second
+		//! \returns the number of packets written
+		//! \throws std::runtime_error if encoding or writing failed
+		uint64_t encode(FrameSource& source, absl::string_view url, unsigned int width, unsigned int height, unsigned int frame_rate);
+
+	private:
+		//! Encode the images [first, first + count) into a recorder
+		void encodeChunk(FrameSource& source, Recorder& rec, uint64_t first, uint64_t count, unsigned int width, unsigned int height, unsigned int frame_rate);
+
+		//! Container format
+		OutputFormat _outputFormat;
+
+		//! Codec used to compress the video
+		CodecType _codec;
+
+		//! Encoder settings of the chunks
+		EncoderSettings _settings;
+
+		//! Chunk configuration
+		ChunkOptions _options;
+
+		//! Layout of MP4 output
+		Mp4Options _mp4Options;
+	};
+}}}
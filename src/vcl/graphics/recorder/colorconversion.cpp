@@ -0,0 +1,151 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "colorconversion.h"
+
+// C++ standard library
+#include <cmath>
+
+// VCL
+#include "colorconversion_kernels.h"
+
+extern "C"
+{
+#include <libavutil/cpu.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Derive the fixed-point coefficients from the luma weights of a matrix
+		//! \param kr Weight of the red channel
+		//! \param kb Weight of the blue channel
+		ColorCoefficients makeCoefficients(double kr, double kb)
+		{
+			const double kg = 1.0 - kr - kb;
+			const double y_scale = 219.0 / 255.0 * (1 << 15);
+			const double c_scale = 224.0 / 255.0 * (1 << 15);
+			const auto q = [](double v) { return static_cast<int32_t>(std::lround(v)); };
+
+			ColorCoefficients c;
+			c.y[0] = q(kr * y_scale);
+			c.y[1] = q(kg * y_scale);
+			c.y[2] = q(kb * y_scale);
+
+			// Balance the green weight, such that grey maps exactly to zero chroma
+			c.u[0] = q(-kr / (2.0 * (1.0 - kb)) * c_scale);
+			c.u[2] = q(0.5 * c_scale);
+			c.u[1] = -c.u[0] - c.u[2];
+			c.v[0] = q(0.5 * c_scale);
+			c.v[2] = q(-kb / (2.0 * (1.0 - kr)) * c_scale);
+			c.v[1] = -c.v[0] - c.v[2];
+
+			return c;
+		}
+
+		template<typename Layout, bool Nv12>
+		struct ScalarKernel
+		{
+			static void run(const ConversionParams& p, int row_begin, int row_end)
+			{
+				const auto& c = colorCoefficients(p.matrix);
+				Kernels::forEachRowPair<Nv12>(p, row_begin, row_end, [&c, &p](const Kernels::RowPair& rows)
+				{
+					Kernels::convertRowPairScalar<Layout, Nv12>(c, rows, 0, p.width);
+				});
+			}
+		};
+	}
+
+	namespace Kernels
+	{
+		void convertRowsScalar(const ConversionParams& params, int row_begin, int row_end)
+		{
+			dispatch<ScalarKernel>(params, row_begin, row_end);
+		}
+
+#ifndef VCL_GRAPHICS_RECORDER_SIMD
+		// Vectorized kernels are only available on x86
+		void convertRowsSse41(const ConversionParams& params, int row_begin, int row_end)
+		{
+			convertRowsScalar(params, row_begin, row_end);
+		}
+		void convertRowsAvx2(const ConversionParams& params, int row_begin, int row_end)
+		{
+			convertRowsScalar(params, row_begin, row_end);
+		}
+#endif
+	}
+
+	SimdLevel detectSimdLevel()
+	{
+#ifdef VCL_GRAPHICS_RECORDER_SIMD
+		const int flags = av_get_cpu_flags();
+		if (flags & AV_CPU_FLAG_AVX2)
+			return SimdLevel::Avx2;
+		if (flags & AV_CPU_FLAG_SSE4)
+			return SimdLevel::Sse41;
+#endif
+		return SimdLevel::Scalar;
+	}
+
+	bool isKernelSupported(PixelFormat src, PixelFormat dst)
+	{
+		const bool src_ok = src == PixelFormat::Rgb24 || src == PixelFormat::Bgr24 || src == PixelFormat::Bgra;
+		const bool dst_ok = dst == PixelFormat::Yuv420P || dst == PixelFormat::Nv12;
+		return src_ok && dst_ok;
+	}
+
+	const ColorCoefficients& colorCoefficients(ColorMatrix matrix)
+	{
+		static const ColorCoefficients bt601 = makeCoefficients(0.299, 0.114);
+		static const ColorCoefficients bt709 = makeCoefficients(0.2126, 0.0722);
+
+		switch (matrix)
+		{
+		case ColorMatrix::Bt709:
+			return bt709;
+		case ColorMatrix::Bt601:
+		default:
+			return bt601;
+		}
+	}
+
+	void convertRows(SimdLevel level, const ConversionParams& params, int row_begin, int row_end)
+	{
+		row_end = std::min(row_end, params.height);
+		switch (level)
+		{
+		case SimdLevel::Avx2:
+			Kernels::convertRowsAvx2(params, row_begin, row_end);
+			break;
+		case SimdLevel::Sse41:
+			Kernels::convertRowsSse41(params, row_begin, row_end);
+			break;
+		case SimdLevel::Scalar:
+		default:
+			Kernels::convertRowsScalar(params, row_begin, row_end);
+			break;
+		}
+	}
+}}}
@@ -0,0 +1,98 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <cstdint>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/pixelformat.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Instruction sets available for the colour conversion kernels
+	enum class SimdLevel
+	{
+		Scalar,
+		Sse41,
+		Avx2
+	};
+
+	//! Fixed-point (Q15) coefficients transforming RGB to limited range YUV
+	//! Each row stores the weights of the red, green and blue channels.
+	struct ColorCoefficients
+	{
+		int32_t y[3];
+		int32_t u[3];
+		int32_t v[3];
+	};
+
+	//! Description of a conversion from a packed RGB image to YUV 4:2:0
+	struct ConversionParams
+	{
+		//! Layout of the source image. Needs to be Rgb24, Bgr24 or Bgra.
+		PixelFormat src_format;
+
+		//! First line of the source image
+		const uint8_t* src;
+
+		//! Distance in bytes between two source lines
+		int src_stride;
+
+		//! Width of source and destination image
+		int width;
+
+		//! Height of source and destination image
+		int height;
+
+		//! Layout of the destination image. Needs to be Yuv420P or Nv12.
+		PixelFormat dst_format;
+
+		//! Destination planes. NV12 uses only the first two planes.
+		uint8_t* dst[3];
+
+		//! Distance in bytes between two lines of each destination plane
+		int dst_stride[3];
+
+		//! Colour matrix applied during the conversion
+		ColorMatrix matrix;
+	};
+
+	//! \returns the best instruction set supported by the executing CPU
+	VCL_GRAPHICS_RECORDER_API SimdLevel detectSimdLevel();
+
+	//! \returns true if the conversion can be executed by a kernel
+	VCL_GRAPHICS_RECORDER_API bool isKernelSupported(PixelFormat src, PixelFormat dst);
+
+	//! \returns the fixed-point coefficients of a colour matrix
+	VCL_GRAPHICS_RECORDER_API const ColorCoefficients& colorCoefficients(ColorMatrix matrix);
+
+	//! Convert a range of lines of an image
+	//! \param level Instruction set to use. Must be supported by the CPU.
+	//! \param params Description of the conversion
+	//! \param row_begin First line to convert. Needs to be even.
+	//! \param row_end Line after the last line to convert
+	//! \note The result does not depend on the chosen instruction set.
+	VCL_GRAPHICS_RECORDER_API void convertRows(SimdLevel level, const ConversionParams& params, int row_begin, int row_end);
+}}}
@@ -0,0 +1,139 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "colorconversion_kernels.h"
+
+// VCL
+#include "colorconversion_x86.h"
+
+// AVX2
+#include <immintrin.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder { namespace Kernels
+{
+	namespace
+	{
+		__m256i combine(__m128i lo, __m128i hi)
+		{
+			return _mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1);
+		}
+
+		//! Weights of a weighted sum of three 16-bit channels
+		struct Weights
+		{
+			Weights(const int32_t* c, int32_t offset)
+			: rg(_mm256_set1_epi32((c[1] << 16) | (c[0] & 0xffff)))
+			, b(_mm256_set1_epi32(c[2] & 0xffff))
+			, offset(_mm256_set1_epi32(offset))
+			{
+			}
+
+			//! Weighted sum of the four lower (hi = false) or upper lanes of each 128-bit half
+			template<int Shift>
+			__m256i apply(__m256i r, __m256i g, __m256i bl, bool hi) const
+			{
+				const __m256i zero = _mm256_setzero_si256();
+				const __m256i rg_pairs = hi ? _mm256_unpackhi_epi16(r, g) : _mm256_unpacklo_epi16(r, g);
+				const __m256i b_pairs = hi ? _mm256_unpackhi_epi16(bl, zero) : _mm256_unpacklo_epi16(bl, zero);
+				const __m256i sum = _mm256_add_epi32(_mm256_madd_epi16(rg_pairs, rg), _mm256_madd_epi16(b_pairs, b));
+				return _mm256_srai_epi32(_mm256_add_epi32(sum, offset), Shift);
+			}
+
+			__m256i rg, b, offset;
+		};
+
+		//! Luma of 16 pixels
+		__m128i lumaRow(const Weights& w, __m256i r, __m256i g, __m256i b)
+		{
+			const __m256i lo = w.apply<15>(r, g, b, false);
+			const __m256i hi = w.apply<15>(r, g, b, true);
+
+			// Packing operates per 128-bit half, gather the results in the lower half
+			const __m256i y = _mm256_packus_epi16(_mm256_packs_epi32(lo, hi), _mm256_setzero_si256());
+			return _mm256_castsi256_si128(_mm256_permute4x64_epi64(y, _MM_SHUFFLE(3, 1, 2, 0)));
+		}
+
+		template<typename Layout, bool Nv12>
+		struct Avx2Kernel
+		{
+			static void run(const ConversionParams& p, int row_begin, int row_end)
+			{
+				const auto& c = colorCoefficients(p.matrix);
+				const Deinterleave<Layout> load;
+				const Weights wy{ c.y, LumaOffset };
+				const Weights wu{ c.u, ChromaOffset };
+				const Weights wv{ c.v, ChromaOffset };
+
+				forEachRowPair<Nv12>(p, row_begin, row_end, [&](const RowPair& rows)
+				{
+					int x = 0;
+					for (; x + 16 <= p.width; x += 16)
+					{
+						__m128i r[4], g[4], b[4];
+						load(rows.src0 + (x + 0) * Layout::bpp, r[0], g[0], b[0]);
+						load(rows.src0 + (x + 8) * Layout::bpp, r[1], g[1], b[1]);
+						load(rows.src1 + (x + 0) * Layout::bpp, r[2], g[2], b[2]);
+						load(rows.src1 + (x + 8) * Layout::bpp, r[3], g[3], b[3]);
+
+						const __m256i r0 = combine(r[0], r[1]), g0 = combine(g[0], g[1]), b0 = combine(b[0], b[1]);
+						const __m256i r1 = combine(r[2], r[3]), g1 = combine(g[2], g[3]), b1 = combine(b[2], b[3]);
+
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(rows.y0 + x), lumaRow(wy, r0, g0, b0));
+						if (rows.y1)
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(rows.y1 + x), lumaRow(wy, r1, g1, b1));
+
+						// Sums of the 2x2 blocks in the four lower lanes of each half
+						const __m256i zero = _mm256_setzero_si256();
+						const __m256i sr = _mm256_hadd_epi16(_mm256_add_epi16(r0, r1), zero);
+						const __m256i sg = _mm256_hadd_epi16(_mm256_add_epi16(g0, g1), zero);
+						const __m256i sb = _mm256_hadd_epi16(_mm256_add_epi16(b0, b1), zero);
+						const __m256i u = wu.apply<17>(sr, sg, sb, false);
+						const __m256i v = wv.apply<17>(sr, sg, sb, false);
+
+						// Bytes per half: u0 u1 u2 u3 v0 v1 v2 v3
+						const __m256i uv = _mm256_packus_epi16(_mm256_packs_epi32(u, v), zero);
+
+						// Bytes: u0 .. u7 v0 .. v7
+						const __m128i planar_u = _mm_unpacklo_epi32(_mm256_castsi256_si128(uv), _mm256_extracti128_si256(uv, 1));
+						const __m128i planar_v = _mm_srli_si128(planar_u, 8);
+						if (Nv12)
+						{
+							_mm_storeu_si128(reinterpret_cast<__m128i*>(rows.u + x), _mm_unpacklo_epi8(planar_u, planar_v));
+						}
+						else
+						{
+							_mm_storel_epi64(reinterpret_cast<__m128i*>(rows.u + x / 2), planar_u);
+							_mm_storel_epi64(reinterpret_cast<__m128i*>(rows.v + x / 2), planar_v);
+						}
+					}
+
+					convertRowPairScalar<Layout, Nv12>(c, rows, x, p.width);
+				});
+			}
+		};
+	}
+
+	void convertRowsAvx2(const ConversionParams& params, int row_begin, int row_end)
+	{
+		dispatch<Avx2Kernel>(params, row_begin, row_end);
+	}
+}}}}
@@ -0,0 +1,177 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+// VCL
+#include <vcl/graphics/recorder/colorconversion.h>
+
+// Building blocks shared by the scalar and the vectorized conversion kernels.
+// All kernels use the same fixed-point arithmetic, such that they produce
+// bit-identical results:
+// * Luma: (c_r*R + c_g*G + c_b*B + (16 << 15) + (1 << 14)) >> 15
+// * Chroma is computed from the sum of a 2x2 block:
+//   (c_r*sum(R) + c_g*sum(G) + c_b*sum(B) + (128 << 17) + (1 << 16)) >> 17
+namespace Vcl { namespace Graphics { namespace Recorder { namespace Kernels
+{
+	void convertRowsScalar(const ConversionParams& params, int row_begin, int row_end);
+	void convertRowsSse41(const ConversionParams& params, int row_begin, int row_end);
+	void convertRowsAvx2(const ConversionParams& params, int row_begin, int row_end);
+
+	// The helpers are compiled with different instruction sets per kernel.
+	// Internal linkage prevents the linker from merging, e.g., an AVX2 build
+	// of a helper into the scalar kernel.
+	namespace {
+
+	//! Rounding and offset of the luma computation
+	const int32_t LumaOffset = (16 << 15) + (1 << 14);
+
+	//! Rounding and offset of the chroma computation
+	const int32_t ChromaOffset = (128 << 17) + (1 << 16);
+
+	//! Byte layout of a packed RGB pixel
+	template<int Bpp, int R, int G, int B>
+	struct PackedLayout
+	{
+		static const int bpp = Bpp;
+		static const int r = R;
+		static const int g = G;
+		static const int b = B;
+	};
+
+	using Rgb24Layout = PackedLayout<3, 0, 1, 2>;
+	using Bgr24Layout = PackedLayout<3, 2, 1, 0>;
+	using BgraLayout = PackedLayout<4, 2, 1, 0>;
+
+	inline uint8_t clampToByte(int32_t v)
+	{
+		return static_cast<uint8_t>(std::min(std::max(v, 0), 255));
+	}
+
+	inline uint8_t luma(const ColorCoefficients& c, int32_t r, int32_t g, int32_t b)
+	{
+		return clampToByte((c.y[0] * r + c.y[1] * g + c.y[2] * b + LumaOffset) >> 15);
+	}
+
+	inline uint8_t chroma(const int32_t* c, int32_t sum_r, int32_t sum_g, int32_t sum_b)
+	{
+		return clampToByte((c[0] * sum_r + c[1] * sum_g + c[2] * sum_b + ChromaOffset) >> 17);
+	}
+
+	//! Pointers to the destination memory of a pair of lines
+	struct RowPair
+	{
+		//! Source lines. 'src1' equals 'src0' for the last line of an odd height image.
+		const uint8_t* src0;
+		const uint8_t* src1;
+
+		//! Destination luma lines. 'y1' is null for the last line of an odd height image.
+		uint8_t* y0;
+		uint8_t* y1;
+
+		//! Destination chroma lines. For NV12 'v' equals 'u + 1'.
+		uint8_t* u;
+		uint8_t* v;
+	};
+
+	//! Convert the pixels [x_begin, width) of a pair of lines
+	//! \param x_begin First pixel to convert. Needs to be even.
+	template<typename Layout, bool Nv12>
+	inline void convertRowPairScalar(const ColorCoefficients& c, const RowPair& rows, int x_begin, int width)
+	{
+		const int chroma_step = Nv12 ? 2 : 1;
+		for (int x = x_begin; x < width; x += 2)
+		{
+			// Replicate the last column for odd widths
+			const int x1 = std::min(x + 1, width - 1);
+			const uint8_t* p00 = rows.src0 + x  * Layout::bpp;
+			const uint8_t* p01 = rows.src0 + x1 * Layout::bpp;
+			const uint8_t* p10 = rows.src1 + x  * Layout::bpp;
+			const uint8_t* p11 = rows.src1 + x1 * Layout::bpp;
+
+			rows.y0[x] = luma(c, p00[Layout::r], p00[Layout::g], p00[Layout::b]);
+			if (x1 != x)
+				rows.y0[x1] = luma(c, p01[Layout::r], p01[Layout::g], p01[Layout::b]);
+			if (rows.y1)
+			{
+				rows.y1[x] = luma(c, p10[Layout::r], p10[Layout::g], p10[Layout::b]);
+				if (x1 != x)
+					rows.y1[x1] = luma(c, p11[Layout::r], p11[Layout::g], p11[Layout::b]);
+			}
+
+			const int32_t sum_r = p00[Layout::r] + p01[Layout::r] + p10[Layout::r] + p11[Layout::r];
+			const int32_t sum_g = p00[Layout::g] + p01[Layout::g] + p10[Layout::g] + p11[Layout::g];
+			const int32_t sum_b = p00[Layout::b] + p01[Layout::b] + p10[Layout::b] + p11[Layout::b];
+			rows.u[(x / 2) * chroma_step] = chroma(c.u, sum_r, sum_g, sum_b);
+			rows.v[(x / 2) * chroma_step] = chroma(c.v, sum_r, sum_g, sum_b);
+		}
+	}
+
+	//! Iterate over the line pairs of a conversion and invoke the row kernel
+	template<bool Nv12, typename RowKernel>
+	inline void forEachRowPair(const ConversionParams& p, int row_begin, int row_end, RowKernel&& kernel)
+	{
+		for (int y = row_begin; y < row_end; y += 2)
+		{
+			const bool has_pair = y + 1 < p.height;
+
+			RowPair rows;
+			rows.src0 = p.src + static_cast<std::ptrdiff_t>(y) * p.src_stride;
+			rows.src1 = has_pair ? rows.src0 + p.src_stride : rows.src0;
+			rows.y0 = p.dst[0] + static_cast<std::ptrdiff_t>(y) * p.dst_stride[0];
+			rows.y1 = has_pair ? rows.y0 + p.dst_stride[0] : nullptr;
+			rows.u = p.dst[1] + static_cast<std::ptrdiff_t>(y / 2) * p.dst_stride[1];
+			rows.v = Nv12 ? rows.u + 1 : p.dst[2] + static_cast<std::ptrdiff_t>(y / 2) * p.dst_stride[2];
+
+			kernel(rows);
+		}
+	}
+
+	//! Instantiate a kernel template for the source and destination format
+	//! of a conversion
+	template<template<typename, bool> class Kernel>
+	inline void dispatch(const ConversionParams& p, int row_begin, int row_end)
+	{
+		const bool nv12 = p.dst_format == PixelFormat::Nv12;
+		switch (p.src_format)
+		{
+		case PixelFormat::Rgb24:
+			nv12 ? Kernel<Rgb24Layout, true>::run(p, row_begin, row_end) : Kernel<Rgb24Layout, false>::run(p, row_begin, row_end);
+			break;
+		case PixelFormat::Bgr24:
+			nv12 ? Kernel<Bgr24Layout, true>::run(p, row_begin, row_end) : Kernel<Bgr24Layout, false>::run(p, row_begin, row_end);
+			break;
+		case PixelFormat::Bgra:
+			nv12 ? Kernel<BgraLayout, true>::run(p, row_begin, row_end) : Kernel<BgraLayout, false>::run(p, row_begin, row_end);
+			break;
+		default:
+			break;
+		}
+	}
+
+	}
+}}}}
@@ -0,0 +1,122 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "colorconversion_kernels.h"
+
+// C++ standard library
+#include <cstring>
+
+// VCL
+#include "colorconversion_x86.h"
+
+namespace Vcl { namespace Graphics { namespace Recorder { namespace Kernels
+{
+	namespace
+	{
+		//! Weights of a weighted sum of three 16-bit channels
+		struct Weights
+		{
+			Weights(const int32_t* c, int32_t offset)
+			: rg(_mm_set1_epi32((c[1] << 16) | (c[0] & 0xffff)))
+			, b(_mm_set1_epi32(c[2] & 0xffff))
+			, offset(_mm_set1_epi32(offset))
+			{
+			}
+
+			//! Weighted sum of the four lower (hi = false) or upper lanes
+			template<int Shift>
+			__m128i apply(__m128i r, __m128i g, __m128i bl, bool hi) const
+			{
+				const __m128i zero = _mm_setzero_si128();
+				const __m128i rg_pairs = hi ? _mm_unpackhi_epi16(r, g) : _mm_unpacklo_epi16(r, g);
+				const __m128i b_pairs = hi ? _mm_unpackhi_epi16(bl, zero) : _mm_unpacklo_epi16(bl, zero);
+				const __m128i sum = _mm_add_epi32(_mm_madd_epi16(rg_pairs, rg), _mm_madd_epi16(b_pairs, b));
+				return _mm_srai_epi32(_mm_add_epi32(sum, offset), Shift);
+			}
+
+			__m128i rg, b, offset;
+		};
+
+		__m128i lumaRow(const Weights& w, __m128i r, __m128i g, __m128i b)
+		{
+			const __m128i lo = w.apply<15>(r, g, b, false);
+			const __m128i hi = w.apply<15>(r, g, b, true);
+			return _mm_packus_epi16(_mm_packs_epi32(lo, hi), _mm_setzero_si128());
+		}
+
+		template<typename Layout, bool Nv12>
+		struct Sse41Kernel
+		{
+			static void run(const ConversionParams& p, int row_begin, int row_end)
+			{
+				const auto& c = colorCoefficients(p.matrix);
+				const Deinterleave<Layout> load;
+				const Weights wy{ c.y, LumaOffset };
+				const Weights wu{ c.u, ChromaOffset };
+				const Weights wv{ c.v, ChromaOffset };
+
+				forEachRowPair<Nv12>(p, row_begin, row_end, [&](const RowPair& rows)
+				{
+					int x = 0;
+					for (; x + 8 <= p.width; x += 8)
+					{
+						__m128i r0, g0, b0, r1, g1, b1;
+						load(rows.src0 + x * Layout::bpp, r0, g0, b0);
+						load(rows.src1 + x * Layout::bpp, r1, g1, b1);
+
+						_mm_storel_epi64(reinterpret_cast<__m128i*>(rows.y0 + x), lumaRow(wy, r0, g0, b0));
+						if (rows.y1)
+							_mm_storel_epi64(reinterpret_cast<__m128i*>(rows.y1 + x), lumaRow(wy, r1, g1, b1));
+
+						// Sums of the 2x2 blocks in the four lower lanes
+						const __m128i sr = _mm_hadd_epi16(_mm_add_epi16(r0, r1), _mm_setzero_si128());
+						const __m128i sg = _mm_hadd_epi16(_mm_add_epi16(g0, g1), _mm_setzero_si128());
+						const __m128i sb = _mm_hadd_epi16(_mm_add_epi16(b0, b1), _mm_setzero_si128());
+						const __m128i u = wu.apply<17>(sr, sg, sb, false);
+						const __m128i v = wv.apply<17>(sr, sg, sb, false);
+
+						// Bytes: u0 u1 u2 u3 v0 v1 v2 v3
+						const __m128i uv = _mm_packus_epi16(_mm_packs_epi32(u, v), _mm_setzero_si128());
+						if (Nv12)
+						{
+							_mm_storel_epi64(reinterpret_cast<__m128i*>(rows.u + x), _mm_unpacklo_epi8(uv, _mm_srli_si128(uv, 4)));
+						}
+						else
+						{
+							const int32_t u4 = _mm_cvtsi128_si32(uv);
+							const int32_t v4 = _mm_extract_epi32(uv, 1);
+							memcpy(rows.u + x / 2, &u4, sizeof(u4));
+							memcpy(rows.v + x / 2, &v4, sizeof(v4));
+						}
+					}
+
+					convertRowPairScalar<Layout, Nv12>(c, rows, x, p.width);
+				});
+			}
+		};
+	}
+
+	void convertRowsSse41(const ConversionParams& params, int row_begin, int row_end)
+	{
+		dispatch<Sse41Kernel>(params, row_begin, row_end);
+	}
+}}}}
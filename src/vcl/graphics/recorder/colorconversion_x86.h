@@ -0,0 +1,84 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// VCL
+#include "colorconversion_kernels.h"
+
+// SSE4.1
+#include <smmintrin.h>
+
+// Helpers shared by the SSE4.1 and AVX2 conversion kernels
+namespace Vcl { namespace Graphics { namespace Recorder { namespace Kernels
+{
+	// See 'colorconversion_kernels.h' for the reason of the internal linkage
+	namespace {
+
+	//! Shuffle mask extracting one channel of pixels into 16-bit lanes
+	//! \param bpp Bytes per pixel
+	//! \param offset Byte offset of the channel in the pixel
+	//! \param first First pixel covered by the register
+	//! \param base Byte offset of the register relative to the first pixel
+	inline __m128i channelMask(int bpp, int offset, int first, int base)
+	{
+		alignas(16) int8_t mask[16];
+		for (int i = 0; i < 8; i++)
+		{
+			const int byte = i * bpp + offset - base;
+			const bool covered = i >= first && i < first + 4 && byte >= 0 && byte < 16;
+			mask[2 * i + 0] = covered ? static_cast<int8_t>(byte) : static_cast<int8_t>(0x80);
+			mask[2 * i + 1] = static_cast<int8_t>(0x80);
+		}
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+	}
+
+	//! Split eight packed pixels into 16-bit channels
+	template<typename Layout>
+	struct Deinterleave
+	{
+		// Packed 24-bit pixels are read through two overlapping loads
+		// covering bytes [0, 16) and [8, 24). 32-bit pixels through two
+		// adjacent loads.
+		static const int HighBase = Layout::bpp == 3 ? 8 : 16;
+
+		Deinterleave()
+		: rLo(channelMask(Layout::bpp, Layout::r, 0, 0)), rHi(channelMask(Layout::bpp, Layout::r, 4, HighBase))
+		, gLo(channelMask(Layout::bpp, Layout::g, 0, 0)), gHi(channelMask(Layout::bpp, Layout::g, 4, HighBase))
+		, bLo(channelMask(Layout::bpp, Layout::b, 0, 0)), bHi(channelMask(Layout::bpp, Layout::b, 4, HighBase))
+		{
+		}
+
+		void operator()(const uint8_t* p, __m128i& r, __m128i& g, __m128i& b) const
+		{
+			const __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			const __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + HighBase));
+			r = _mm_or_si128(_mm_shuffle_epi8(lo, rLo), _mm_shuffle_epi8(hi, rHi));
+			g = _mm_or_si128(_mm_shuffle_epi8(lo, gLo), _mm_shuffle_epi8(hi, gHi));
+			b = _mm_or_si128(_mm_shuffle_epi8(lo, bLo), _mm_shuffle_epi8(hi, bHi));
+		}
+
+		__m128i rLo, rHi, gLo, gHi, bLo, bHi;
+	};
+
+	}
+}}}}
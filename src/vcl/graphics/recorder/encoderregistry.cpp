@@ -0,0 +1,195 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "encoderregistry.h"
+
+// VCL
+#include "frameconverter.h"
+
+// C++ standard library
+#include <stdexcept>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Size of the video used to trial-open the encoders. Hardware
+		//! encoders reject very small images, thus stay above their limits.
+		const int ProbeWidth = 256;
+		const int ProbeHeight = 144;
+	}
+
+	std::vector<const char*> encoderCandidates(CodecType codec_cfg)
+	{
+		if (codec_cfg == CodecType::H264)
+		{
+			// List of available hardware encoders in FFmpeg 4
+			// https://stackoverflow.com/a/50703794
+			// * h264_amf to access AMD gpu
+			// * h264_nvenc use nvidia gpu cards
+			// * h264_omx raspberry pi encoder
+			// * h264_qsv use Intel Quick Sync Video (hardware embedded in modern Intel CPU)
+			// * h264_v4l2m2m use V4L2 Linux kernel api to access hardware codecs
+			// * h264_vaapi use VAAPI which is another abstraction API to access video acceleration hardware
+			// * h264_videotoolbox use videotoolbox an API to access hardware on OS X
+			return { "h264_nvenc", "h264_qsv", "libopenh264", "libx264" };
+		}
+		else if (codec_cfg == CodecType::Hevc)
+		{
+			return { "hevc_nvenc", "hevc_qsv", "libx265" };
+		}
+		else if (codec_cfg == CodecType::Vp9)
+		{
+			return { "libvpx-vp9" };
+		}
+		else if (codec_cfg == CodecType::Av1)
+		{
+			return { "libaom-av1" };
+		}
+		else if (codec_cfg == CodecType::Ffv1)
+		{
+			return { "ffv1" };
+		}
+
+		throw std::domain_error("Invalid codec definition");
+	}
+
+	AVPixelFormat negotiatePixelFormat(const AVCodec* codec)
+	{
+		if (!codec->pix_fmts)
+			return AV_PIX_FMT_YUV420P;
+
+		// Prefer the formats supported by the vectorized conversion kernels
+		for (const auto preferred : { AV_PIX_FMT_YUV420P, AV_PIX_FMT_NV12 })
+		{
+			for (const AVPixelFormat* fmt = codec->pix_fmts; *fmt != AV_PIX_FMT_NONE; fmt++)
+			{
+				if (*fmt == preferred)
+					return preferred;
+			}
+		}
+
+		return codec->pix_fmts[0];
+	}
+
+	void configureOpenRequirements(const AVCodec* codec, AVCodecContext* ctx)
+	{
+		// Experimental encoders, e.g. libaom in FFmpeg 4.0, refuse to open otherwise
+		if (codec->capabilities & AV_CODEC_CAP_EXPERIMENTAL)
+			ctx->strict_std_compliance = FF_COMPLIANCE_EXPERIMENTAL;
+	}
+
+	EncoderRegistry& EncoderRegistry::instance()
+	{
+		static EncoderRegistry registry;
+		return registry;
+	}
+
+	std::vector<EncoderCapabilities> EncoderRegistry::encoders(CodecType codec)
+	{
+		// Validate the codec before probing
+		const auto candidates = encoderCandidates(codec);
+
+		std::lock_guard<std::mutex> lock{ _mutex };
+		auto entry = _encoders.find(codec);
+		if (entry == _encoders.end())
+		{
+			std::vector<EncoderCapabilities> probed;
+			for (const char* name : candidates)
+				probed.emplace_back(probe(name));
+
+			entry = _encoders.emplace(codec, std::move(probed)).first;
+		}
+
+		return entry->second;
+	}
+
+	std::string EncoderRegistry::preferredEncoder(CodecType codec)
+	{
+		for (const auto& encoder : encoders(codec))
+		{
+			if (encoder.usable)
+				return encoder.name;
+		}
+
+		return {};
+	}
+
+	void EncoderRegistry::reset()
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		_encoders.clear();
+	}
+
+	EncoderCapabilities EncoderRegistry::probe(const char* name)
+	{
+		const auto start = std::chrono::steady_clock::now();
+
+		EncoderCapabilities caps;
+		caps.name = name;
+
+		const AVCodec* codec = avcodec_find_encoder_by_name(name);
+		if (codec)
+		{
+			caps.available = true;
+			caps.input_format = negotiatePixelFormat(codec);
+			if (codec->pix_fmts)
+			{
+				for (const AVPixelFormat* fmt = codec->pix_fmts; *fmt != AV_PIX_FMT_NONE; fmt++)
+				{
+					PixelFormat layout;
+					if (fromAVPixelFormat(*fmt, layout))
+						caps.pixel_formats.emplace_back(layout);
+				}
+			}
+			else
+			{
+				caps.pixel_formats.emplace_back(PixelFormat::Yuv420P);
+			}
+
+			// Hardware encoders only fail once opened without device
+			AVCodecContext* ctx = avcodec_alloc_context3(codec);
+			if (ctx)
+			{
+				ctx->width = ProbeWidth;
+				ctx->height = ProbeHeight;
+				ctx->time_base = { 1, 25 };
+				ctx->framerate = { 25, 1 };
+				ctx->pix_fmt = caps.input_format;
+				ctx->thread_count = 1;
+				configureOpenRequirements(codec, ctx);
+
+				_probes.fetch_add(1, std::memory_order_relaxed);
+				caps.usable = avcodec_open2(ctx, codec, nullptr) >= 0;
+				avcodec_free_context(&ctx);
+			}
+		}
+
+		caps.probe_time = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+		return caps;
+	}
+}}}
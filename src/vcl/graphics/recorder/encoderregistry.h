@@ -0,0 +1,128 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// Abseil
+#include <absl/strings/string_view.h>
+
+// C++ standard library
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/pixelformat.h>
+#include <vcl/graphics/recorder/recorder.h>
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+
+	struct AVCodec;
+	struct AVCodecContext;
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Encoders implementing a codec in the order of preference
+	//! \throws std::domain_error for invalid codec definitions
+	VCL_GRAPHICS_RECORDER_API std::vector<const char*> encoderCandidates(CodecType codec);
+
+	//! Select the input format of an encoder
+	VCL_GRAPHICS_RECORDER_API AVPixelFormat negotiatePixelFormat(const AVCodec* codec);
+
+	//! Apply the options an encoder requires to be opened at all
+	//! Used by the recorder and when probing, such that an encoder is not
+	//! reported unusable for reasons the recorder would take care of.
+	VCL_GRAPHICS_RECORDER_API void configureOpenRequirements(const AVCodec* codec, AVCodecContext* ctx);
+
+	//! Result of probing an encoder
+	struct EncoderCapabilities
+	{
+		//! Name of the FFmpeg encoder
+		std::string name;
+
+		//! The encoder is part of the FFmpeg build
+		bool available{false};
+
+		//! The encoder could be opened on this machine
+		bool usable{false};
+
+		//! Input formats supported by the encoder which can be passed to the
+		//! recorder without conversion
+		std::vector<PixelFormat> pixel_formats;
+
+		//! Input format selected by the recorder
+		AVPixelFormat input_format{AV_PIX_FMT_NONE};
+
+		//! Time spent probing the encoder
+		std::chrono::microseconds probe_time{0};
+	};
+
+	//! Process-wide cache of the encoders which can be used
+	//! Hardware encoders are part of many FFmpeg builds, but can only be
+	//! opened if the hardware and drivers are present. Each candidate is thus
+	//! opened once at a small size, and the result is kept for the lifetime
+	//! of the process.
+	class VCL_GRAPHICS_RECORDER_API EncoderRegistry
+	{
+	public:
+		//! Registry shared by all recorders
+		static EncoderRegistry& instance();
+
+		//! Capabilities of the candidate encoders of a codec
+		//! The candidates are probed on first use. Can be called concurrently.
+		//! \returns the candidates in the order of preference
+		std::vector<EncoderCapabilities> encoders(CodecType codec);
+
+		//! Name of the preferred encoder which could be opened
+		//! \returns an empty string if no candidate is usable
+		std::string preferredEncoder(CodecType codec);
+
+		//! Forget the probing results, e.g. after installing drivers
+		void reset();
+
+		//! Number of encoders opened for probing
+		uint64_t probeCount() const { return _probes.load(std::memory_order_relaxed); }
+
+	private:
+		EncoderRegistry() = default;
+
+		//! Trial-open an encoder
+		EncoderCapabilities probe(const char* name);
+
+		//! Probing results per codec
+		std::map<CodecType, std::vector<EncoderCapabilities>> _encoders;
+
+		//! Protects the probing results. Held while probing, such that
+		//! concurrent callers wait for a single probe.
+		std::mutex _mutex;
+
+		//! Number of encoders opened for probing
+		std::atomic<uint64_t> _probes{0};
+	};
+}}}
@@ -0,0 +1,74 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// Abseil
+#include <absl/types/optional.h>
+
+// C++ standard library
+#include <cstdint>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Predefined trade-offs between encoding speed and compression
+	enum class EncoderProfile
+	{
+		//! Fastest encoding with minimal delay. No B-frames, intended for
+		//! live capture (libx264: ultrafast, zerolatency).
+		Realtime,
+
+		//! Moderate speed and compression (libx264: medium)
+		Balanced,
+
+		//! Small, high quality files at high CPU cost (libx264: slow)
+		Archive
+	};
+
+	//! Configuration of the encoder
+	//! Values which are not set explicitly are taken from the profile.
+	//! The settings are mapped onto each encoder of the fallback chain,
+	//! options an encoder does not support are ignored.
+	struct EncoderSettings
+	{
+		EncoderSettings() = default;
+		EncoderSettings(EncoderProfile p) : profile(p) {}
+
+		//! Base profile
+		EncoderProfile profile{EncoderProfile::Archive};
+
+		//! Target bit rate in bits per second
+		//! Used by encoders without constant quality mode (libopenh264)
+		//! and as rate limit by hardware encoders.
+		absl::optional<int64_t> bit_rate;
+
+		//! Maximum distance between two key frames
+		absl::optional<int> gop_size;
+
+		//! Maximum number of consecutive B-frames
+		absl::optional<int> max_b_frames;
+
+		//! Constant quality level, lower is better (0-51 for H.264).
+		//! Maps to 'crf' (libx264), 'cq' (h264_nvenc) or the global quality (h264_qsv).
+		absl::optional<int> quality;
+	};
+}}}
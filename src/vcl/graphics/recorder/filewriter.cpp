@@ -0,0 +1,283 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "filewriter.h"
+
+// C++ standard library
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#ifdef _WIN32
+#	include <fcntl.h>
+#	include <io.h>
+#	include <sys/stat.h>
+#else
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Smallest block passed to the writer thread
+		const size_t MinBlockSize = 64 * 1024;
+
+		//! Number of blocks the buffer is split into
+		const size_t BlockCount = 8;
+	}
+
+	WriterStats WriterCounters::snapshot() const
+	{
+		WriterStats stats;
+		stats.queue_depth = queue_depth.load(std::memory_order_relaxed);
+		stats.max_queue_depth = max_queue_depth.load(std::memory_order_relaxed);
+		stats.stalls = stalls.load(std::memory_order_relaxed);
+		stats.stall_time = std::chrono::nanoseconds{ stall_time.load(std::memory_order_relaxed) };
+		stats.syncs = syncs.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	void WriterCounters::reset()
+	{
+		max_queue_depth = queue_depth.load(std::memory_order_relaxed);
+		stalls = 0;
+		stall_time = 0;
+		syncs = 0;
+	}
+
+	FileWriter::FileWriter(absl::string_view path, const FileWriterOptions& options, std::shared_ptr<WriterCounters> counters)
+	: _options(options)
+	, _blocks(std::max<size_t>(2, options.buffer_size / std::max(options.buffer_size / BlockCount, MinBlockSize)))
+	, _pending(_blocks.size())
+	, _free(_blocks.size())
+	, _counters(counters ? std::move(counters) : std::make_shared<WriterCounters>())
+	{
+		const std::string file_name{ path };
+#ifdef _WIN32
+		_fd = _open(file_name.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+#else
+		_fd = ::open(file_name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+#endif
+		if (_fd < 0)
+			throw std::runtime_error("Opening output failed");
+
+#ifdef __linux__
+		// Reserve the space without changing the size. Not every file system
+		// supports it, which is not an error.
+		if (_options.preallocate > 0)
+			fallocate(_fd, FALLOC_FL_KEEP_SIZE, 0, static_cast<off_t>(_options.preallocate));
+#endif
+
+		const size_t block_size = std::max(options.buffer_size / BlockCount, MinBlockSize);
+		for (auto& block : _blocks)
+		{
+			block.data.resize(block_size);
+			_free.push(&block);
+		}
+
+		_writerThread = std::thread{ [this]() { writerLoop(); } };
+	}
+
+	FileWriter::~FileWriter()
+	{
+		close();
+	}
+
+	bool FileWriter::write(const uint8_t* data, size_t size)
+	{
+		if (_failed || _fd < 0)
+			return false;
+
+		while (size > 0)
+		{
+			if (!_current)
+			{
+				// Wait for the disk if all blocks are in use
+				if (_free.size() == 0)
+				{
+					const auto start = std::chrono::steady_clock::now();
+					if (!_free.pop(_current))
+						return false;
+					const auto stall = std::chrono::steady_clock::now() - start;
+
+					_counters->stalls.fetch_add(1, std::memory_order_relaxed);
+					_counters->stall_time.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(stall).count(), std::memory_order_relaxed);
+				}
+				else if (!_free.pop(_current))
+				{
+					return false;
+				}
+				_current->size = 0;
+				_current->offset = _position;
+			}
+
+			const size_t chunk = std::min(size, _current->data.size() - _current->size);
+			std::memcpy(_current->data.data() + _current->size, data, chunk);
+			_current->size += chunk;
+			_position += static_cast<int64_t>(chunk);
+			_size = std::max(_size, _position);
+			data += chunk;
+			size -= chunk;
+
+			if (_current->size == _current->data.size())
+				submit();
+		}
+
+		return !_failed;
+	}
+
+	int64_t FileWriter::seek(int64_t offset, int whence)
+	{
+		int64_t position = -1;
+		switch (whence)
+		{
+		case SEEK_SET: position = offset; break;
+		case SEEK_CUR: position = _position + offset; break;
+		case SEEK_END: position = _size + offset; break;
+		default: return -1;
+		}
+		if (position < 0)
+			return -1;
+
+		// Blocks store consecutive data. The blocks are written in order,
+		// thus re-written data replaces the earlier data.
+		if (position != _position)
+			submit();
+
+		_position = position;
+		return _position;
+	}
+
+	bool FileWriter::close()
+	{
+		if (_fd < 0)
+			return !_failed;
+
+		submit();
+		_pending.close();
+		_writerThread.join();
+
+		if (_options.sync != SyncPolicy::Never && !_failed)
+			sync();
+
+#ifdef _WIN32
+		if (_close(_fd) < 0)
+#else
+		if (::close(_fd) < 0)
+#endif
+			_failed = true;
+		_fd = -1;
+
+		return !_failed;
+	}
+
+	void FileWriter::submit()
+	{
+		if (!_current)
+			return;
+
+		if (_current->size > 0)
+		{
+			const uint64_t depth = _counters->queue_depth.fetch_add(_current->size, std::memory_order_relaxed) + _current->size;
+			uint64_t max_depth = _counters->max_queue_depth.load(std::memory_order_relaxed);
+			while (depth > max_depth && !_counters->max_queue_depth.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed))
+				;
+
+			_pending.push(_current);
+		}
+		else
+		{
+			_free.push(_current);
+		}
+		_current = nullptr;
+	}
+
+	void FileWriter::writerLoop()
+	{
+		Block* block = nullptr;
+		while (_pending.pop(block))
+		{
+			// Drop the data after an error, the file is unusable anyway
+			if (!_failed && !writeBlock(*block))
+				_failed = true;
+			_counters->queue_depth.fetch_sub(block->size, std::memory_order_relaxed);
+
+			_unsynced += block->size;
+			if (_options.sync == SyncPolicy::Periodic && _unsynced >= _options.sync_interval && !_failed)
+				sync();
+
+			_free.push(block);
+		}
+	}
+
+	bool FileWriter::writeBlock(const Block& block)
+	{
+		const uint8_t* data = block.data.data();
+		size_t remaining = block.size;
+		int64_t offset = block.offset;
+		while (remaining > 0)
+		{
+#ifdef _WIN32
+			if (_lseeki64(_fd, offset, SEEK_SET) < 0)
+				return false;
+			const auto written = _write(_fd, data, static_cast<unsigned int>(remaining));
+#else
+			const auto written = pwrite(_fd, data, remaining, static_cast<off_t>(offset));
+#endif
+			if (written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				return false;
+			}
+
+			data += written;
+			offset += written;
+			remaining -= static_cast<size_t>(written);
+		}
+
+		return true;
+	}
+
+	void FileWriter::sync()
+	{
+#if defined(_WIN32)
+		const int result = _commit(_fd);
+#elif defined(__linux__)
+		const int result = fdatasync(_fd);
+#else
+		const int result = fsync(_fd);
+#endif
+		if (result < 0)
+			_failed = true;
+
+		_unsynced = 0;
+		_counters->syncs.fetch_add(1, std::memory_order_relaxed);
+	}
+}}}
@@ -0,0 +1,173 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// Abseil
+#include <absl/strings/string_view.h>
+
+// C++ standard library
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/boundedqueue.h>
+#include <vcl/graphics/recorder/sink.h>
+#include <vcl/graphics/recorder/stats.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Point in time data is synchronized to the disk
+	enum class SyncPolicy
+	{
+		//! Leave it to the operating system
+		Never,
+
+		//! Synchronize when closing the file
+		OnClose,
+
+		//! Synchronize every 'sync_interval' bytes and when closing the file
+		Periodic
+	};
+
+	//! Configuration of the writer thread
+	struct FileWriterOptions
+	{
+		//! Amount of data buffered in memory before the muxer waits for the disk
+		size_t buffer_size{8 * 1024 * 1024};
+
+		//! Disk space reserved up-front to reduce fragmentation. The size of
+		//! the file is not changed. Only supported on Linux.
+		uint64_t preallocate{0};
+
+		//! Synchronization of the data to the disk
+		SyncPolicy sync{SyncPolicy::Never};
+
+		//! Number of bytes between synchronizations in 'Periodic' mode
+		uint64_t sync_interval{64 * 1024 * 1024};
+	};
+
+	//! Counters of the writers of a recording
+	//! Shared by consecutive files, e.g. when writing segments.
+	struct WriterCounters
+	{
+		std::atomic<uint64_t> queue_depth{0};
+		std::atomic<uint64_t> max_queue_depth{0};
+		std::atomic<uint64_t> stalls{0};
+		std::atomic<uint64_t> stall_time{0};
+		std::atomic<uint64_t> syncs{0};
+
+		WriterStats snapshot() const;
+
+		//! Clear the accumulated counters. The current queue depth is kept.
+		void reset();
+	};
+
+	//! Sink writing a file on a dedicated thread
+	//! The data is copied into large blocks, which are written by the writer
+	//! thread. Thus a slow disk only stalls the muxer once the buffer is full.
+	class VCL_GRAPHICS_RECORDER_API FileWriter : public OutputSink
+	{
+	public:
+		//! Create the file and start the writer thread
+		//! \param path Name of the file
+		//! \param options Buffering and synchronization of the file
+		//! \param counters Counters to update. 'nullptr' to use private counters.
+		//! \throws std::runtime_error if the file cannot be created
+		FileWriter(absl::string_view path, const FileWriterOptions& options, std::shared_ptr<WriterCounters> counters = nullptr);
+		FileWriter(const FileWriter&) = delete;
+		FileWriter& operator=(const FileWriter&) = delete;
+		~FileWriter() override;
+
+		bool write(const uint8_t* data, size_t size) override;
+		int64_t seek(int64_t offset, int whence) override;
+		int64_t size() const override { return _size; }
+		bool isSeekable() const override { return true; }
+
+		//! Write the buffered data and close the file
+		//! \returns false if writing any of the data failed
+		bool close() override;
+
+		WriterStats stats() const { return _counters->snapshot(); }
+
+	private:
+		//! Consecutive data written at a position of the file
+		struct Block
+		{
+			std::vector<uint8_t> data;
+			size_t size{0};
+			int64_t offset{0};
+		};
+
+		//! Pass the current block to the writer thread
+		void submit();
+
+		//! Thread function writing the blocks
+		void writerLoop();
+
+		//! Write a block to the file
+		bool writeBlock(const Block& block);
+
+		//! Synchronize the written data to the disk
+		void sync();
+
+		//! File descriptor
+		int _fd{-1};
+
+		//! Configuration
+		FileWriterOptions _options;
+
+		//! Storage of the blocks
+		std::vector<Block> _blocks;
+
+		//! Blocks waiting to be written
+		BoundedQueue<Block*> _pending;
+
+		//! Blocks available for new data
+		BoundedQueue<Block*> _free;
+
+		//! Block currently filled by the muxer
+		Block* _current{nullptr};
+
+		//! Thread writing the blocks
+		std::thread _writerThread;
+
+		//! Logical write position
+		int64_t _position{0};
+
+		//! Logical size of the file
+		int64_t _size{0};
+
+		//! Bytes written since the last synchronization
+		uint64_t _unsynced{0};
+
+		//! Writing data failed
+		std::atomic<bool> _failed{false};
+
+		//! Statistics
+		std::shared_ptr<WriterCounters> _counters;
+	};
+}}}
@@ -0,0 +1,193 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "frameconverter.h"
+
+// C++ standard library
+#include <algorithm>
+#include <thread>
+
+// VCL
+#include "threadpool.h"
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	AVPixelFormat toAVPixelFormat(PixelFormat fmt)
+	{
+		switch (fmt)
+		{
+		case PixelFormat::Yuv420P: return AV_PIX_FMT_YUV420P;
+		case PixelFormat::Nv12:    return AV_PIX_FMT_NV12;
+		case PixelFormat::Rgb24:   return AV_PIX_FMT_RGB24;
+		case PixelFormat::Bgr24:   return AV_PIX_FMT_BGR24;
+		case PixelFormat::Bgra:    return AV_PIX_FMT_BGRA;
+		default:                   return AV_PIX_FMT_NONE;
+		}
+	}
+
+	bool fromAVPixelFormat(AVPixelFormat av_fmt, PixelFormat& fmt)
+	{
+		switch (av_fmt)
+		{
+		case AV_PIX_FMT_YUV420P: fmt = PixelFormat::Yuv420P; return true;
+		case AV_PIX_FMT_NV12:    fmt = PixelFormat::Nv12;    return true;
+		case AV_PIX_FMT_RGB24:   fmt = PixelFormat::Rgb24;   return true;
+		case AV_PIX_FMT_BGR24:   fmt = PixelFormat::Bgr24;   return true;
+		case AV_PIX_FMT_BGRA:    fmt = PixelFormat::Bgra;    return true;
+		default:                 return false;
+		}
+	}
+
+	FrameConverter::FrameConverter()
+	: _simdLevel{detectSimdLevel()}
+	{
+	}
+
+	FrameConverter::~FrameConverter()
+	{
+		sws_freeContext(_swsCtx);
+	}
+
+	void FrameConverter::setSliceCount(unsigned int slices)
+	{
+		if (slices == 0)
+			slices = std::max(1u, std::thread::hardware_concurrency());
+		if (slices == _slices)
+			return;
+
+		// The calling thread converts one of the slices
+		_slices = slices;
+		_pool = slices > 1 ? std::make_unique<ThreadPool>(slices - 1) : nullptr;
+	}
+
+	bool FrameConverter::convert
+	(
+		const uint8_t* const src[4],
+		const int src_stride[4],
+		AVPixelFormat src_fmt,
+		int src_w,
+		int src_h,
+		AVFrame* dst
+	)
+	{
+		// Use the dedicated kernels if no scaling is required
+		PixelFormat src_layout, dst_layout;
+		if (src_w == dst->width && src_h == dst->height &&
+			fromAVPixelFormat(src_fmt, src_layout) &&
+			fromAVPixelFormat(static_cast<AVPixelFormat>(dst->format), dst_layout) &&
+			isKernelSupported(src_layout, dst_layout))
+		{
+			ConversionParams params;
+			params.src_format = src_layout;
+			params.src = src[0];
+			params.src_stride = src_stride[0];
+			params.width = src_w;
+			params.height = src_h;
+			params.dst_format = dst_layout;
+			for (int i = 0; i < 3; i++)
+			{
+				params.dst[i] = dst->data[i];
+				params.dst_stride[i] = dst->linesize[i];
+			}
+			params.matrix = _matrix;
+
+			// Split the image into slices of an even number of lines, such
+			// that no chroma line is shared between two slices.
+			const int line_pairs = (src_h + 1) / 2;
+			const int slices = std::min(static_cast<int>(_slices), line_pairs);
+			if (slices <= 1 || !_pool)
+			{
+				convertRows(_simdLevel, params, 0, src_h);
+				return true;
+			}
+
+			// The loop state is captured through a single reference. This keeps
+			// the function object small enough to not allocate memory per frame.
+			struct SliceLoop
+			{
+				const ConversionParams* params;
+				SimdLevel level;
+				int line_pairs;
+				int slices;
+			} loop{ &params, _simdLevel, line_pairs, slices };
+
+			_pool->parallelFor(static_cast<unsigned int>(slices), [&loop](unsigned int slice)
+			{
+				const int begin = 2 * (loop.line_pairs * static_cast<int>(slice) / loop.slices);
+				const int end = 2 * (loop.line_pairs * static_cast<int>(slice + 1) / loop.slices);
+				convertRows(loop.level, *loop.params, begin, end);
+			});
+			return true;
+		}
+
+		return scale(src, src_stride, src_fmt, src_w, src_h, dst);
+	}
+
+	bool FrameConverter::scale
+	(
+		const uint8_t* const src[4],
+		const int src_stride[4],
+		AVPixelFormat src_fmt,
+		int src_w,
+		int src_h,
+		AVFrame* dst
+	)
+	{
+		// Returns the current context if the parameters did not change
+		SwsContext* sws_ctx = sws_getCachedContext(
+			_swsCtx,
+			src_w,
+			src_h,
+			src_fmt,
+			dst->width,
+			dst->height,
+			static_cast<AVPixelFormat>(dst->format),
+			SWS_BICUBIC, nullptr, nullptr, nullptr
+		);
+		if (!sws_ctx)
+			return false;
+
+		// A recreated context uses the default colour matrix (BT.601)
+		const std::array<int, 6> key = { src_w, src_h, src_fmt, dst->width, dst->height, dst->format };
+		if (key != _swsKey)
+			_swsMatrix = ColorMatrix::Bt601;
+		_swsKey = key;
+		_swsCtx = sws_ctx;
+
+		if (_swsMatrix != _matrix)
+		{
+			const int cs = _matrix == ColorMatrix::Bt709 ? SWS_CS_ITU709 : SWS_CS_ITU601;
+			const int* coeffs = sws_getCoefficients(cs);
+			sws_setColorspaceDetails(_swsCtx, coeffs, 0, coeffs, 0, 0, 1 << 16, 1 << 16);
+			_swsMatrix = _matrix;
+		}
+
+		const int lines = sws_scale(_swsCtx, src, src_stride, 0, src_h, dst->data, dst->linesize);
+		return lines == dst->height;
+	}
+}}}
@@ -0,0 +1,133 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <array>
+#include <cstdint>
+#include <memory>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/colorconversion.h>
+#include <vcl/graphics/recorder/pixelformat.h>
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+
+	struct AVFrame;
+	struct SwsContext;
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	class ThreadPool;
+
+	//! Map a pixel format to the FFmpeg definition
+	VCL_GRAPHICS_RECORDER_API AVPixelFormat toAVPixelFormat(PixelFormat fmt);
+
+	//! Map an FFmpeg pixel format to the recorder definition
+	//! \returns false if the format has no equivalent
+	VCL_GRAPHICS_RECORDER_API bool fromAVPixelFormat(AVPixelFormat av_fmt, PixelFormat& fmt);
+
+	//! Colour conversion stage converting input images into the
+	//! format expected by the encoder.
+	//! Packed RGB images matching the destination size are converted by the
+	//! vectorized kernels. All other conversions use swscale. The scaling
+	//! context is cached and only recreated when the source or destination
+	//! format or size changes.
+	class VCL_GRAPHICS_RECORDER_API FrameConverter
+	{
+	public:
+		FrameConverter();
+		FrameConverter(const FrameConverter&) = delete;
+		FrameConverter& operator=(const FrameConverter&) = delete;
+		~FrameConverter();
+
+		//! Set the colour matrix used for RGB to YUV conversions
+		void setColorMatrix(ColorMatrix matrix) { _matrix = matrix; }
+		ColorMatrix colorMatrix() const { return _matrix; }
+
+		//! Set the number of horizontal slices converted in parallel
+		//! \param slices Number of slices. 0 selects the number of hardware threads.
+		void setSliceCount(unsigned int slices);
+		unsigned int sliceCount() const { return _slices; }
+
+		//! Override the instruction set used by the conversion kernels
+		//! \param level Instruction set. Must be supported by the CPU.
+		void setSimdLevel(SimdLevel level) { _simdLevel = level; }
+		SimdLevel simdLevel() const { return _simdLevel; }
+
+		//! Convert an image into the planes of a frame
+		//! \param src Plane pointers of the source image
+		//! \param src_stride Line sizes of the source image
+		//! \param src_fmt Pixel format of the source image
+		//! \param src_w Width of the source image
+		//! \param src_h Height of the source image
+		//! \param dst Frame with allocated planes. Format and size of the
+		//!            frame define the conversion target.
+		bool convert
+		(
+			const uint8_t* const src[4],
+			const int src_stride[4],
+			AVPixelFormat src_fmt,
+			int src_w,
+			int src_h,
+			AVFrame* dst
+		);
+
+	private:
+		//! Convert using swscale
+		bool scale
+		(
+			const uint8_t* const src[4],
+			const int src_stride[4],
+			AVPixelFormat src_fmt,
+			int src_w,
+			int src_h,
+			AVFrame* dst
+		);
+
+		//! Cached scaling context
+		SwsContext* _swsCtx{nullptr};
+
+		//! Source and destination size and format of the scaling context
+		std::array<int, 6> _swsKey{};
+
+		//! Colour matrix configured in the scaling context
+		ColorMatrix _swsMatrix{ColorMatrix::Bt601};
+
+		//! Colour matrix for RGB to YUV conversions
+		ColorMatrix _matrix{ColorMatrix::Bt601};
+
+		//! Instruction set used by the conversion kernels
+		SimdLevel _simdLevel{SimdLevel::Scalar};
+
+		//! Number of slices processed in parallel
+		unsigned int _slices{1};
+
+		//! Workers converting the slices
+		std::unique_ptr<ThreadPool> _pool;
+	};
+}}}
@@ -0,0 +1,191 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "framepool.h"
+
+// C++ standard library
+#include <stdexcept>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+#include <libavutil/frame.h>
+#include <libavutil/imgutils.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Alignment of the rows of pooled frames, matches 'av_frame_get_buffer(frame, 32)'
+		const int RowAlignment = 32;
+
+		//! Additional bytes allowing optimized readers to overread the image
+		const int BufferPadding = 64;
+	}
+
+	FramePool::FramePool(AVPixelFormat fmt, int width, int height, size_t capacity)
+	: _format(fmt)
+	, _width(width)
+	, _height(height)
+	, _capacity(capacity)
+	{
+		// Determine the layout of the image
+		const int aligned_width = (width + RowAlignment - 1) / RowAlignment * RowAlignment;
+		if (av_image_fill_linesizes(_linesize.data(), fmt, aligned_width) < 0)
+			throw std::runtime_error("Unsupported pixel format");
+		for (auto& linesize : _linesize)
+			linesize = (linesize + RowAlignment - 1) / RowAlignment * RowAlignment;
+
+		uint8_t* data[4] = { nullptr, nullptr, nullptr, nullptr };
+		const int size = av_image_fill_pointers(data, fmt, height, nullptr, _linesize.data());
+		if (size < 0)
+			throw std::runtime_error("Unsupported pixel format");
+
+		_buffers = av_buffer_pool_init2(size + BufferPadding, this, allocateBuffer, nullptr);
+		if (!_buffers)
+			throw std::runtime_error("Allocating buffer pool failed");
+
+		_frames.reserve(capacity);
+	}
+
+	FramePool::~FramePool()
+	{
+		for (auto frame : _frames)
+			av_frame_free(&frame);
+
+		// Buffers still in use are freed once released
+		av_buffer_pool_uninit(&_buffers);
+	}
+
+	AVFrame* FramePool::get()
+	{
+		AVFrame* frame = getEmpty();
+		if (!frame)
+			return nullptr;
+
+		frame->buf[0] = av_buffer_pool_get(_buffers);
+		if (!frame->buf[0])
+		{
+			put(frame);
+			return nullptr;
+		}
+
+		frame->format = _format;
+		frame->width = _width;
+		frame->height = _height;
+		for (int p = 0; p < 4; p++)
+			frame->linesize[p] = _linesize[p];
+		av_image_fill_pointers(frame->data, _format, _height, frame->buf[0]->data, frame->linesize);
+
+		return frame;
+	}
+
+	AVFrame* FramePool::getEmpty()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			if (!_frames.empty())
+			{
+				AVFrame* frame = _frames.back();
+				_frames.pop_back();
+				return frame;
+			}
+		}
+
+		_allocations.fetch_add(1, std::memory_order_relaxed);
+		return av_frame_alloc();
+	}
+
+	void FramePool::put(AVFrame* frame)
+	{
+		if (!frame)
+			return;
+
+		av_frame_unref(frame);
+
+		std::unique_lock<std::mutex> lock{ _mutex };
+		if (_frames.size() < _capacity)
+		{
+			_frames.push_back(frame);
+			return;
+		}
+		lock.unlock();
+
+		av_frame_free(&frame);
+	}
+
+	AVBufferRef* FramePool::allocateBuffer(void* opaque, int size)
+	{
+		auto pool = static_cast<FramePool*>(opaque);
+		pool->_allocations.fetch_add(1, std::memory_order_relaxed);
+
+		return av_buffer_alloc(size);
+	}
+
+	PacketPool::PacketPool(size_t capacity)
+	: _capacity(capacity)
+	{
+		_packets.reserve(capacity);
+	}
+
+	PacketPool::~PacketPool()
+	{
+		for (auto pkt : _packets)
+			av_packet_free(&pkt);
+	}
+
+	AVPacket* PacketPool::get()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			if (!_packets.empty())
+			{
+				AVPacket* pkt = _packets.back();
+				_packets.pop_back();
+				return pkt;
+			}
+		}
+
+		_allocations.fetch_add(1, std::memory_order_relaxed);
+		return av_packet_alloc();
+	}
+
+	void PacketPool::put(AVPacket* pkt)
+	{
+		if (!pkt)
+			return;
+
+		av_packet_unref(pkt);
+
+		std::unique_lock<std::mutex> lock{ _mutex };
+		if (_packets.size() < _capacity)
+		{
+			_packets.push_back(pkt);
+			return;
+		}
+		lock.unlock();
+
+		av_packet_free(&pkt);
+	}
+}}}
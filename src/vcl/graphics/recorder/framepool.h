@@ -0,0 +1,138 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+
+extern "C"
+{
+#include <libavutil/pixfmt.h>
+
+	struct AVBufferPool;
+	struct AVBufferRef;
+	struct AVFrame;
+	struct AVPacket;
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Recycles frames and their image buffers
+	//! Once a recording reached its steady state, frames are served from
+	//! the pool without allocating memory. Frames can be acquired and
+	//! returned from different threads.
+	class VCL_GRAPHICS_RECORDER_API FramePool
+	{
+	public:
+		//! Create a pool of frames of a single format
+		//! \param capacity Number of frame objects kept for reuse
+		FramePool(AVPixelFormat fmt, int width, int height, size_t capacity);
+		FramePool(const FramePool&) = delete;
+		FramePool& operator=(const FramePool&) = delete;
+		~FramePool();
+
+		//! Get a frame with an image buffer
+		//! \returns nullptr if the allocation failed
+		AVFrame* get();
+
+		//! Get a frame without image buffer
+		//! \returns nullptr if the allocation failed
+		AVFrame* getEmpty();
+
+		//! Return a frame to the pool
+		//! The references held by the frame are released.
+		void put(AVFrame* frame);
+
+		//! Number of frame objects and image buffers allocated by the pool
+		uint64_t allocations() const { return _allocations.load(std::memory_order_relaxed); }
+
+	private:
+		//! Allocation function of the buffer pool
+		static AVBufferRef* allocateBuffer(void* opaque, int size);
+
+		//! Format of the pooled frames
+		AVPixelFormat _format;
+		int _width;
+		int _height;
+
+		//! Line sizes of the pooled frames
+		std::array<int, 4> _linesize;
+
+		//! Pool of the image buffers
+		AVBufferPool* _buffers{nullptr};
+
+		//! Frame objects available for reuse
+		std::vector<AVFrame*> _frames;
+
+		//! Number of frame objects kept for reuse
+		size_t _capacity;
+
+		//! Protects the list of frames
+		std::mutex _mutex;
+
+		//! Number of allocations performed
+		std::atomic<uint64_t> _allocations{0};
+	};
+
+	//! Recycles packet objects
+	class VCL_GRAPHICS_RECORDER_API PacketPool
+	{
+	public:
+		//! \param capacity Number of packet objects kept for reuse
+		explicit PacketPool(size_t capacity);
+		PacketPool(const PacketPool&) = delete;
+		PacketPool& operator=(const PacketPool&) = delete;
+		~PacketPool();
+
+		//! Get an empty packet
+		//! \returns nullptr if the allocation failed
+		AVPacket* get();
+
+		//! Return a packet to the pool
+		//! The data referenced by the packet is released.
+		void put(AVPacket* pkt);
+
+		//! Number of packet objects allocated by the pool
+		uint64_t allocations() const { return _allocations.load(std::memory_order_relaxed); }
+
+	private:
+		//! Packet objects available for reuse
+		std::vector<AVPacket*> _packets;
+
+		//! Number of packet objects kept for reuse
+		size_t _capacity;
+
+		//! Protects the list of packets
+		std::mutex _mutex;
+
+		//! Number of allocations performed
+		std::atomic<uint64_t> _allocations{0};
+	};
+}}}
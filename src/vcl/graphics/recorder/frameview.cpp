@@ -0,0 +1,141 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "frameview.h"
+
+// C++ standard library
+#include <stdexcept>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	FrameView FrameView::yuv420p
+	(
+		gsl::span<const uint8_t> y, int y_stride,
+		gsl::span<const uint8_t> u, int u_stride,
+		gsl::span<const uint8_t> v, int v_stride,
+		unsigned int width, unsigned int height
+	)
+	{
+		FrameView view;
+		view.format = PixelFormat::Yuv420P;
+		view.width = width;
+		view.height = height;
+		view.planes = { y, u, v };
+		view.strides = {{ y_stride, u_stride, v_stride }};
+		return view;
+	}
+
+	FrameView FrameView::nv12
+	(
+		gsl::span<const uint8_t> y, int y_stride,
+		gsl::span<const uint8_t> uv, int uv_stride,
+		unsigned int width, unsigned int height
+	)
+	{
+		FrameView view;
+		view.format = PixelFormat::Nv12;
+		view.width = width;
+		view.height = height;
+		view.planes = { y, uv, {} };
+		view.strides = {{ y_stride, uv_stride, 0 }};
+		return view;
+	}
+
+	FrameView FrameView::packed(gsl::span<const uint8_t> pixels, int stride, PixelFormat fmt, unsigned int width, unsigned int height)
+	{
+		if (fmt != PixelFormat::Rgb24 && fmt != PixelFormat::Bgr24 && fmt != PixelFormat::Bgra)
+			throw std::domain_error("Pixel format is not a packed RGB format");
+
+		FrameView view;
+		view.format = fmt;
+		view.width = width;
+		view.height = height;
+		view.planes = { pixels, {}, {} };
+		view.strides = {{ stride, 0, 0 }};
+		return view;
+	}
+
+	int FrameView::planeCount(PixelFormat fmt)
+	{
+		switch (fmt)
+		{
+		case PixelFormat::Yuv420P:
+			return 3;
+		case PixelFormat::Nv12:
+			return 2;
+		case PixelFormat::Rgb24:
+		case PixelFormat::Bgr24:
+		case PixelFormat::Bgra:
+			return 1;
+		default:
+			throw std::domain_error("Invalid pixel format definition");
+		}
+	}
+
+	int FrameView::rowBytes(PixelFormat fmt, int plane, unsigned int width)
+	{
+		const int w = static_cast<int>(width);
+		const int chroma_w = (w + 1) / 2;
+		switch (fmt)
+		{
+		case PixelFormat::Yuv420P:
+			return plane == 0 ? w : chroma_w;
+		case PixelFormat::Nv12:
+			return plane == 0 ? w : 2 * chroma_w;
+		case PixelFormat::Rgb24:
+		case PixelFormat::Bgr24:
+			return 3 * w;
+		case PixelFormat::Bgra:
+			return 4 * w;
+		default:
+			throw std::domain_error("Invalid pixel format definition");
+		}
+	}
+
+	int FrameView::rowCount(PixelFormat fmt, int plane, unsigned int height)
+	{
+		const int h = static_cast<int>(height);
+		if ((fmt == PixelFormat::Yuv420P || fmt == PixelFormat::Nv12) && plane > 0)
+			return (h + 1) / 2;
+
+		return h;
+	}
+
+	void FrameView::validate() const
+	{
+		if (width == 0 || height == 0)
+			throw std::domain_error("Frame is empty");
+
+		const int nr_planes = planeCount(format);
+		for (int p = 0; p < nr_planes; p++)
+		{
+			const int row_bytes = rowBytes(format, p, width);
+			const int rows = rowCount(format, p, height);
+			if (strides[p] < row_bytes)
+				throw std::domain_error("Stride is smaller than a row of the frame");
+
+			const int64_t required = static_cast<int64_t>(strides[p]) * (rows - 1) + row_bytes;
+			if (planes[p].data() == nullptr || static_cast<int64_t>(planes[p].size()) < required)
+				throw std::domain_error("Plane is smaller than required by the frame size");
+		}
+	}
+}}}
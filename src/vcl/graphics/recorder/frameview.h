@@ -0,0 +1,95 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <array>
+#include <cstdint>
+
+// GSL
+#include <gsl/gsl>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/pixelformat.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Non-owning view onto an image in caller memory
+	//! Planes can be padded, the distance between two rows is given by the
+	//! stride of the plane. The last row of a plane does not need padding.
+	struct VCL_GRAPHICS_RECORDER_API FrameView
+	{
+		//! Maximum number of planes of the supported pixel formats
+		static const int MaxPlanes = 3;
+
+		//! Create a view onto a planar YUV 4:2:0 image
+		static FrameView yuv420p
+		(
+			gsl::span<const uint8_t> y, int y_stride,
+			gsl::span<const uint8_t> u, int u_stride,
+			gsl::span<const uint8_t> v, int v_stride,
+			unsigned int width, unsigned int height
+		);
+
+		//! Create a view onto a semi-planar YUV 4:2:0 image
+		static FrameView nv12
+		(
+			gsl::span<const uint8_t> y, int y_stride,
+			gsl::span<const uint8_t> uv, int uv_stride,
+			unsigned int width, unsigned int height
+		);
+
+		//! Create a view onto a packed RGB image
+		//! \param fmt Layout of the image. Needs to be Rgb24, Bgr24 or Bgra.
+		static FrameView packed(gsl::span<const uint8_t> pixels, int stride, PixelFormat fmt, unsigned int width, unsigned int height);
+
+		//! Number of planes used by a pixel format
+		static int planeCount(PixelFormat fmt);
+
+		//! Number of bytes of the visible part of a row of a plane
+		static int rowBytes(PixelFormat fmt, int plane, unsigned int width);
+
+		//! Number of rows of a plane
+		static int rowCount(PixelFormat fmt, int plane, unsigned int height);
+
+		//! Check if the planes cover the image described by format, size and strides
+		//! \throws std::domain_error if the view is inconsistent
+		void validate() const;
+
+		//! Layout of the image
+		PixelFormat format{PixelFormat::Yuv420P};
+
+		//! Width of the image in pixels
+		unsigned int width{0};
+
+		//! Height of the image in pixels
+		unsigned int height{0};
+
+		//! Memory of the individual planes
+		std::array<gsl::span<const uint8_t>, MaxPlanes> planes;
+
+		//! Distance in bytes between the starts of two consecutive rows
+		std::array<int, MaxPlanes> strides{{0, 0, 0}};
+	};
+}}}
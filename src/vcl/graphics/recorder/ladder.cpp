@@ -0,0 +1,305 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "ladder.h"
+
+// VCL
+#include "frameconverter.h"
+#include "threadpool.h"
+
+// C++ standard library
+#include <chrono>
+#include <stdexcept>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	struct Ladder::Rung
+	{
+		//! Size and output of the rung
+		LadderRung config;
+
+		//! Encoder and container of the rung
+		std::unique_ptr<Recorder> recorder;
+
+		//! Scales the image of the rung above into 'image'
+		std::unique_ptr<FrameConverter> scaler;
+
+		//! Scaled image passed to the encoder
+		AVFrame* image{nullptr};
+
+		//! Number of encoded images
+		std::atomic<uint64_t> frames{0};
+
+		//! Accumulated processing times in nanoseconds
+		std::atomic<int64_t> scaleTime{0};
+		std::atomic<int64_t> encodeTime{0};
+	};
+
+	namespace
+	{
+		int64_t elapsedNs(std::chrono::steady_clock::time_point start)
+		{
+			return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+		}
+
+		FrameView imageView(const AVFrame* frame)
+		{
+			const size_t w = static_cast<size_t>(frame->width);
+			const size_t h = static_cast<size_t>(frame->height);
+			return FrameView::yuv420p
+			(
+				{ frame->data[0], static_cast<std::ptrdiff_t>(frame->linesize[0] * (h - 1) + w) }, frame->linesize[0],
+				{ frame->data[1], static_cast<std::ptrdiff_t>(frame->linesize[1] * (h / 2 - 1) + w / 2) }, frame->linesize[1],
+				{ frame->data[2], static_cast<std::ptrdiff_t>(frame->linesize[2] * (h / 2 - 1) + w / 2) }, frame->linesize[2],
+				frame->width, frame->height
+			);
+		}
+	}
+
+	Ladder::Ladder(OutputFormat out_fmt, CodecType codec, std::vector<LadderRung> rungs)
+	{
+		if (rungs.empty())
+			throw std::domain_error("Ladder requires at least one rung");
+
+		for (size_t r = 0; r < rungs.size(); r++)
+		{
+			const auto& rung = rungs[r];
+			if (rung.width == 0 || rung.height == 0 || rung.width % 2 != 0 || rung.height % 2 != 0)
+				throw std::domain_error("Rung sizes need to be even and non-zero");
+			if (r > 0 && (rung.width > rungs[r - 1].width || rung.height > rungs[r - 1].height))
+				throw std::domain_error("Rungs need to be ordered from the largest to the smallest");
+		}
+
+		_converter = std::make_unique<FrameConverter>();
+		_threads = static_cast<unsigned int>(rungs.size() - 1);
+
+		_rungs.reserve(rungs.size());
+		for (auto& config : rungs)
+		{
+			auto rung = std::make_unique<Rung>();
+			rung->recorder = std::make_unique<Recorder>(out_fmt, codec, config.settings);
+			rung->scaler = std::make_unique<FrameConverter>();
+			rung->config = std::move(config);
+			_rungs.emplace_back(std::move(rung));
+		}
+	}
+
+	Ladder::~Ladder()
+	{
+		close();
+	}
+
+	void Ladder::setThreads(unsigned int threads)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the number of threads while the ladder is open");
+
+		_threads = threads;
+	}
+
+	void Ladder::setColorMatrix(ColorMatrix matrix)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the colour matrix while the ladder is open");
+
+		// The rungs are encoded from the converted image, thus only tag the encoders
+		_converter->setColorMatrix(matrix);
+		for (auto& rung : _rungs)
+			rung->recorder->setColorMatrix(matrix);
+	}
+
+	Recorder& Ladder::recorder(size_t rung)
+	{
+		return *_rungs.at(rung)->recorder;
+	}
+
+	const Recorder& Ladder::recorder(size_t rung) const
+	{
+		return *_rungs.at(rung)->recorder;
+	}
+
+	void Ladder::open(unsigned int frame_rate)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Ladder is already open");
+
+		// The ladder is not open yet, thus neither 'close' nor the
+		// destructor release the images allocated before a failure
+		try
+		{
+			for (auto& rung : _rungs)
+			{
+				rung->image = av_frame_alloc();
+				if (!rung->image)
+					throw std::runtime_error("Allocating rung image failed");
+				rung->image->format = AV_PIX_FMT_YUV420P;
+				rung->image->width = static_cast<int>(rung->config.width);
+				rung->image->height = static_cast<int>(rung->config.height);
+				if (av_frame_get_buffer(rung->image, 32) < 0)
+					throw std::runtime_error("Allocating rung image failed");
+
+				rung->frames = 0;
+				rung->scaleTime = 0;
+				rung->encodeTime = 0;
+			}
+		}
+		catch (...)
+		{
+			for (auto& rung : _rungs)
+				av_frame_free(&rung->image);
+			throw;
+		}
+
+		// Open the outputs only after all memory is available
+		try
+		{
+			for (auto& rung : _rungs)
+				rung->recorder->open(rung->config.url, rung->config.width, rung->config.height, frame_rate);
+		}
+		catch (...)
+		{
+			for (auto& rung : _rungs)
+			{
+				rung->recorder->close();
+				av_frame_free(&rung->image);
+			}
+			throw;
+		}
+
+		if (_threads > 0)
+			_pool = std::make_unique<ThreadPool>(_threads);
+		_isOpen = true;
+	}
+
+	bool Ladder::write(const FrameView& view)
+	{
+		if (!_isOpen)
+			return false;
+		view.validate();
+
+		// Convert the input once into the first rung
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const uint8_t* src[4] = { nullptr, nullptr, nullptr, nullptr };
+			int src_stride[4] = { 0, 0, 0, 0 };
+			for (int p = 0; p < FrameView::planeCount(view.format); p++)
+			{
+				src[p] = view.planes[p].data();
+				src_stride[p] = view.strides[p];
+			}
+			if (!_converter->convert(src, src_stride, toAVPixelFormat(view.format), static_cast<int>(view.width), static_cast<int>(view.height), _rungs[0]->image))
+				return false;
+			_rungs[0]->scaleTime.fetch_add(elapsedNs(start), std::memory_order_relaxed);
+		}
+
+		// Each rung is scaled from the next larger one
+		for (size_t r = 1; r < _rungs.size(); r++)
+		{
+			const auto start = std::chrono::steady_clock::now();
+			const AVFrame* above = _rungs[r - 1]->image;
+			if (!_rungs[r]->scaler->convert(above->data, above->linesize, AV_PIX_FMT_YUV420P, above->width, above->height, _rungs[r]->image))
+				return false;
+			_rungs[r]->scaleTime.fetch_add(elapsedNs(start), std::memory_order_relaxed);
+		}
+
+		// The encoders are independent, thus the rungs are encoded in parallel.
+		// The recorders copy the images, which can be overwritten afterwards.
+		std::atomic<bool> written{ true };
+		const auto encode = [this, &written](unsigned int r)
+		{
+			auto& rung = *_rungs[r];
+			const auto start = std::chrono::steady_clock::now();
+			if (rung.recorder->write(imageView(rung.image)))
+				rung.frames.fetch_add(1, std::memory_order_relaxed);
+			else
+				written = false;
+			rung.encodeTime.fetch_add(elapsedNs(start), std::memory_order_relaxed);
+		};
+		if (_pool)
+		{
+			_pool->parallelFor(static_cast<unsigned int>(_rungs.size()), encode);
+		}
+		else
+		{
+			for (unsigned int r = 0; r < _rungs.size(); r++)
+				encode(r);
+		}
+
+		return written;
+	}
+
+	bool Ladder::close()
+	{
+		if (!_isOpen)
+			return true;
+
+		// Flush the encoders in parallel, as they might hold many frames
+		std::atomic<bool> closed{true};
+		const auto flush = [this, &closed](unsigned int r)
+		{
+			auto& rung = *_rungs[r];
+			const auto start = std::chrono::steady_clock::now();
+			if (!rung.recorder->close())
+				closed = false;
+			rung.encodeTime.fetch_add(elapsedNs(start), std::memory_order_relaxed);
+		};
+		if (_pool)
+		{
+			_pool->parallelFor(static_cast<unsigned int>(_rungs.size()), flush);
+		}
+		else
+		{
+			for (unsigned int r = 0; r < _rungs.size(); r++)
+				flush(r);
+		}
+
+		for (auto& rung : _rungs)
+			av_frame_free(&rung->image);
+		_pool.reset();
+		_isOpen = false;
+
+		return closed;
+	}
+
+	std::vector<RungStats> Ladder::stats() const
+	{
+		std::vector<RungStats> stats;
+		stats.reserve(_rungs.size());
+		for (const auto& rung : _rungs)
+		{
+			RungStats s;
+			s.width = rung->config.width;
+			s.height = rung->config.height;
+			s.frames = rung->frames.load(std::memory_order_relaxed);
+			s.scale_time = std::chrono::nanoseconds{ rung->scaleTime.load(std::memory_order_relaxed) };
+			s.encode_time = std::chrono::nanoseconds{ rung->encodeTime.load(std::memory_order_relaxed) };
+			stats.emplace_back(s);
+		}
+
+		return stats;
+	}
+}}}
@@ -0,0 +1,132 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/encodersettings.h>
+#include <vcl/graphics/recorder/frameview.h>
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/stats.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	class FrameConverter;
+	class ThreadPool;
+
+	//! Resolution and output of a single version of a ladder
+	struct LadderRung
+	{
+		//! Size of the encoded video
+		unsigned int width{0};
+		unsigned int height{0};
+
+		//! Path of the file to create
+		std::string url;
+
+		//! Encoder configuration of the rung
+		EncoderSettings settings;
+	};
+
+	//! Encodes several resolutions of the same input
+	//! The input is converted once into the pixel format and size of the
+	//! first rung. Every following rung is downscaled from the rung above,
+	//! thus each scaling step only touches the pixels of the next larger
+	//! image. The rungs are encoded in parallel, each writing its own output.
+	class VCL_GRAPHICS_RECORDER_API Ladder
+	{
+	public:
+		//! Create the ladder
+		//! \param out_fmt Container format of all rungs
+		//! \param codec Codec used to compress the rungs
+		//! \param rungs Versions to encode, ordered from the largest to the smallest
+		//! \throws std::domain_error if the rungs are empty, have an invalid size
+		//!         or are larger than the rung above
+		Ladder(OutputFormat out_fmt, CodecType codec, std::vector<LadderRung> rungs);
+		Ladder(const Ladder&) = delete;
+		Ladder& operator=(const Ladder&) = delete;
+		~Ladder();
+
+		//! Set the number of threads encoding the rungs
+		//! \param threads Number of worker threads. The thread calling 'write'
+		//!                participates in addition. Defaults to one per
+		//!                additional rung.
+		//! \note Needs to be configured before calling 'open'
+		void setThreads(unsigned int threads);
+
+		//! Select the colour matrix used to convert RGB input
+		//! \note Needs to be configured before calling 'open'
+		void setColorMatrix(ColorMatrix matrix);
+
+		//! Create the outputs of all rungs
+		//! \param frame_rate Frames per second
+		void open(unsigned int frame_rate);
+
+		//! Convert, scale and encode an image
+		//! The image can have any size, it is scaled to the first rung.
+		//! \returns false if one of the rungs failed to encode the image
+		bool write(const FrameView& view);
+
+		//! Flush the encoders and close all outputs
+		//! \returns false if one of the outputs could not be completed
+		bool close();
+
+		bool isOpen() const { return _isOpen; }
+
+		//! \returns the number of rungs
+		size_t rungCount() const { return _rungs.size(); }
+
+		//! Access the recorder encoding a rung
+		Recorder& recorder(size_t rung);
+		const Recorder& recorder(size_t rung) const;
+
+		//! Snapshot of the throughput of every rung
+		//! Can be called concurrently to 'write'.
+		std::vector<RungStats> stats() const;
+
+	private:
+		//! State of a single rung
+		struct Rung;
+
+		//! Rungs ordered from the largest to the smallest
+		std::vector<std::unique_ptr<Rung>> _rungs;
+
+		//! Converts the input into the first rung
+		std::unique_ptr<FrameConverter> _converter;
+
+		//! Workers encoding the rungs
+		std::unique_ptr<ThreadPool> _pool;
+
+		//! Number of workers encoding the rungs
+		unsigned int _threads{0};
+
+		//! Ladder is accepting images
+		bool _isOpen{false};
+	};
+}}}
@@ -0,0 +1,60 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <chrono>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Arrangement of the index and the media data in MP4 files
+	enum class Mp4Layout
+	{
+		//! Index written at the end of the file when closing
+		Default,
+
+		//! Index moved to the front of the file when closing, allowing
+		//! playback to start before the file is completely downloaded.
+		//! Closing re-reads and re-writes the complete file.
+		Faststart,
+
+		//! Fragmented MP4 (CMAF). An empty index is written up-front and
+		//! the media data is stored in self-contained fragments. Closing
+		//! does not re-write the file, and a file which was not closed
+		//! is playable up to the last complete fragment.
+		Fragmented
+	};
+
+	//! Configuration of MP4 output. Ignored by other containers.
+	struct Mp4Options
+	{
+		//! Arrangement of the file
+		Mp4Layout layout{Mp4Layout::Faststart};
+
+		//! Duration of a fragment in fragmented mode. 0 starts a new
+		//! fragment at every keyframe. Otherwise a new fragment is started
+		//! once the duration is reached, which is only aligned to keyframes
+		//! if the duration is a multiple of the GOP duration.
+		std::chrono::milliseconds fragment_duration{0};
+	};
+}}}
@@ -0,0 +1,310 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "muxer.h"
+
+// VCL
+#include "sink.h"
+
+// C++ standard library
+#include <cstring>
+#include <stdexcept>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Size of the buffer between the container and a sink
+		const int SinkBufferSize = 64 * 1024;
+
+		int writeToSink(void* opaque, uint8_t* buf, int buf_size)
+		{
+			auto sink = static_cast<OutputSink*>(opaque);
+			return sink->write(buf, static_cast<size_t>(buf_size)) ? buf_size : AVERROR(EIO);
+		}
+
+		int64_t seekSink(void* opaque, int64_t offset, int whence)
+		{
+			auto sink = static_cast<OutputSink*>(opaque);
+			if (whence & AVSEEK_SIZE)
+				return sink->size();
+
+			const int64_t pos = sink->seek(offset, whence & ~AVSEEK_FORCE);
+			return pos < 0 ? AVERROR(EIO) : pos;
+		}
+	}
+
+	Muxer::Muxer(OutputFormat fmt)
+	: _format(fmt)
+	{
+		// Validate the container definition early
+		outputFormat(fmt);
+	}
+
+	Muxer::~Muxer()
+	{
+		close();
+	}
+
+	AVOutputFormat* Muxer::outputFormat(OutputFormat fmt)
+	{
+		AVOutputFormat* out_fmt = nullptr;
+		switch (fmt)
+		{
+		case OutputFormat::Avi:
+			out_fmt = av_guess_format("avi", nullptr, nullptr);
+			break;
+		case OutputFormat::Mkv:
+			out_fmt = av_guess_format("matroska", nullptr, nullptr);
+			break;
+		case OutputFormat::Mp4:
+			out_fmt = av_guess_format("mp4", nullptr, nullptr);
+			break;
+		default:
+			throw std::domain_error("Invalid output format definition");
+		}
+
+		if (out_fmt == nullptr)
+			throw std::runtime_error("Unable to allocate AVOutputFormat");
+
+		return out_fmt;
+	}
+
+	void Muxer::open(absl::string_view url, const AVCodecContext* codec, const Mp4Options& mp4)
+	{
+		if (isOpen())
+			throw std::runtime_error("Output is already open");
+
+		create(url, codec);
+		if (avio_open(&_fmtCtx->pb, _fmtCtx->url, AVIO_FLAG_WRITE) < 0)
+		{
+			destroy();
+			throw std::runtime_error("Opening output failed");
+		}
+
+		writeHeader(mp4);
+	}
+
+	void Muxer::open(std::shared_ptr<OutputSink> sink, const AVCodecContext* codec, const Mp4Options& mp4)
+	{
+		if (isOpen())
+			throw std::runtime_error("Output is already open");
+		if (!sink)
+			throw std::domain_error("Invalid output sink");
+
+		// The name is only used for diagnostic output
+		create("sink", codec);
+
+		// Route the output of the container through the sink
+		auto buffer = static_cast<unsigned char*>(av_malloc(SinkBufferSize));
+		if (buffer)
+			_fmtCtx->pb = avio_alloc_context(buffer, SinkBufferSize, 1, sink.get(), nullptr, writeToSink, sink->isSeekable() ? seekSink : nullptr);
+		if (!_fmtCtx->pb)
+		{
+			av_free(buffer);
+			destroy();
+			throw std::runtime_error("Allocating sink IO context failed");
+		}
+		_fmtCtx->pb->seekable = sink->isSeekable() ? AVIO_SEEKABLE_NORMAL : 0;
+		_sink = std::move(sink);
+
+		// Moving the index requires re-reading the output, which a sink does not support
+		Mp4Options sink_mp4 = mp4;
+		if (sink_mp4.layout == Mp4Layout::Faststart)
+			sink_mp4.layout = Mp4Layout::Default;
+		writeHeader(sink_mp4);
+	}
+
+	void Muxer::open(absl::string_view url, const AVCodecParameters* par, AVRational time_base, const Mp4Options& mp4)
+	{
+		if (isOpen())
+			throw std::runtime_error("Output is already open");
+
+		createStream(url);
+		_stream->time_base = time_base;
+		if (avcodec_parameters_copy(_stream->codecpar, par) < 0)
+		{
+			destroy();
+			throw std::runtime_error("Copying codec parameters failed");
+		}
+		av_dump_format(_fmtCtx, 0, _fmtCtx->url, 1);
+
+		if (avio_open(&_fmtCtx->pb, _fmtCtx->url, AVIO_FLAG_WRITE) < 0)
+		{
+			destroy();
+			throw std::runtime_error("Opening output failed");
+		}
+
+		writeHeader(mp4);
+	}
+
+	void Muxer::create(absl::string_view url, const AVCodecContext* codec)
+	{
+		createStream(url);
+
+		// Transfer context to stream
+		_stream->time_base = codec->time_base;
+		if (avcodec_parameters_from_context(_stream->codecpar, codec) < 0)
+		{
+			destroy();
+			throw std::runtime_error("Extracting codec parameters failed");
+		}
+
+		// Debug output
+		av_dump_format(_fmtCtx, 0, _fmtCtx->url, 1);
+	}
+
+	void Muxer::createStream(absl::string_view url)
+	{
+		_fmtCtx = avformat_alloc_context();
+		if (_fmtCtx == nullptr)
+			throw std::runtime_error("Cannot allocate AVFormatContext");
+		_fmtCtx->oformat = outputFormat(_format);
+
+		// Set the output name
+		const auto url_len = url.size() + 1;
+		_fmtCtx->url = static_cast<char*>(av_malloc(url_len));
+		if (_fmtCtx->url == nullptr)
+		{
+			destroy();
+			throw std::runtime_error("Cannot allocate output name");
+		}
+		memset(_fmtCtx->url, 0, url_len);
+		url.copy(_fmtCtx->url, url.size());
+
+		// Create the video recording stream
+		if (!(_stream = avformat_new_stream(_fmtCtx, nullptr)))
+		{
+			destroy();
+			throw std::runtime_error("Failed creating recording stream");
+		}
+	}
+
+	void Muxer::writeHeader(const Mp4Options& mp4)
+	{
+		AVDictionary* fmt_opts = nullptr;
+
+		// Reference for AvFormatContext options: https://ffmpeg.org/doxygen/2.8/movenc_8c_source.html
+		// Set format's privater options, to be passed to avformat_write_header()
+		switch (mp4.layout)
+		{
+		case Mp4Layout::Faststart:
+			av_dict_set(&fmt_opts, "movflags", "faststart", 0);
+			break;
+		case Mp4Layout::Fragmented:
+			// Self-contained fragments addressed relative to their 'moof' box as required by CMAF
+			if (mp4.fragment_duration.count() > 0)
+			{
+				av_dict_set(&fmt_opts, "movflags", "empty_moov+default_base_moof", 0);
+				av_dict_set_int(&fmt_opts, "frag_duration", std::chrono::duration_cast<std::chrono::microseconds>(mp4.fragment_duration).count(), 0);
+			}
+			else
+			{
+				av_dict_set(&fmt_opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+			}
+			break;
+		default:
+			break;
+		}
+
+		// default brand is "isom", which fails on some devices
+		av_dict_set(&fmt_opts, "brand", "mp42", 0);
+
+		const int av_err = avformat_write_header(_fmtCtx, &fmt_opts);
+		av_dict_free(&fmt_opts);
+		if (av_err < 0) {
+			destroy();
+			if (av_err == AVERROR_INVALIDDATA)
+				throw std::runtime_error("Writing AV header failed: Invalid data");
+			else
+				throw std::runtime_error("Writing AV header failed");
+		}
+	}
+
+	bool Muxer::close()
+	{
+		if (!isOpen())
+			return true;
+
+		// The output is released even if the trailer is incomplete
+		const bool trailer = av_write_trailer(_fmtCtx) >= 0;
+		const bool closed = destroy();
+		return trailer && closed;
+	}
+
+	bool Muxer::destroy()
+	{
+		bool closed = true;
+		if (_fmtCtx->pb)
+		{
+			if (_sink)
+			{
+				avio_flush(_fmtCtx->pb);
+				closed = _fmtCtx->pb->error >= 0;
+				av_freep(&_fmtCtx->pb->buffer);
+				avio_context_free(&_fmtCtx->pb);
+			}
+			else
+			{
+				closed = avio_closep(&_fmtCtx->pb) >= 0;
+			}
+		}
+		if (_sink)
+		{
+			closed = _sink->close() && closed;
+			_sink.reset();
+		}
+
+		avformat_free_context(_fmtCtx);
+		_fmtCtx = nullptr;
+		_stream = nullptr;
+
+		return closed;
+	}
+
+	bool Muxer::write(AVPacket* pkt, AVRational time_base)
+	{
+		av_packet_rescale_ts(pkt, time_base, _stream->time_base);
+		pkt->stream_index = _stream->index;
+
+		// Write the packet to the output
+		const int av_err = av_interleaved_write_frame(_fmtCtx, pkt);
+		av_packet_unref(pkt);
+
+		return av_err >= 0;
+	}
+
+	int64_t Muxer::bytesWritten() const
+	{
+		if (!isOpen() || !_fmtCtx->pb)
+			return 0;
+
+		return avio_tell(_fmtCtx->pb);
+	}
+}}}
@@ -0,0 +1,127 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// Abseil
+#include <absl/strings/string_view.h>
+
+// C++ standard library
+#include <cstdint>
+#include <memory>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/mp4options.h>
+#include <vcl/graphics/recorder/recorder.h>
+
+extern "C"
+{
+#include <libavutil/rational.h>
+
+	struct AVCodecContext;
+	struct AVCodecParameters;
+	struct AVFormatContext;
+	struct AVOutputFormat;
+	struct AVPacket;
+	struct AVStream;
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	class OutputSink;
+
+	//! Writes the packets of a single video stream into a container
+	//! A muxer can be opened repeatedly, each time creating a new output.
+	class VCL_GRAPHICS_RECORDER_API Muxer
+	{
+	public:
+		explicit Muxer(OutputFormat fmt);
+		Muxer(const Muxer&) = delete;
+		Muxer& operator=(const Muxer&) = delete;
+		~Muxer();
+
+		//! Look up the FFmpeg definition of a container
+		//! \throws std::domain_error for invalid definitions
+		static AVOutputFormat* outputFormat(OutputFormat fmt);
+
+		//! Create a file and write the container header
+		//! \param url Path of the output file
+		//! \param codec Opened codec providing the stream parameters
+		//! \param mp4 Layout of MP4 files
+		void open(absl::string_view url, const AVCodecContext* codec, const Mp4Options& mp4);
+
+		//! Write the container into a sink
+		//! \param sink Destination of the data. Kept alive until 'close'.
+		//! \param codec Opened codec providing the stream parameters
+		//! \param mp4 Layout of MP4 output. A sink cannot be re-read, thus 'Faststart'
+		//!            is written as 'Default'.
+		void open(std::shared_ptr<OutputSink> sink, const AVCodecContext* codec, const Mp4Options& mp4);
+
+		//! Create a file for a stream encoded elsewhere
+		//! \param url Path of the output file
+		//! \param par Parameters of the encoded stream
+		//! \param time_base Time base of the stream
+		//! \param mp4 Layout of MP4 files
+		void open(absl::string_view url, const AVCodecParameters* par, AVRational time_base, const Mp4Options& mp4);
+
+		//! Write the trailer and close the output
+		//! \returns false if the trailer or buffered data could not be written
+		bool close();
+
+		bool isOpen() const { return _fmtCtx != nullptr; }
+
+		//! Write an encoded packet
+		//! \param pkt Packet to write. The data is released.
+		//! \param time_base Time base of the packet timestamps
+		bool write(AVPacket* pkt, AVRational time_base);
+
+		//! \returns the number of bytes written to the current output
+		int64_t bytesWritten() const;
+
+	private:
+		//! Create the format context and the video stream
+		void create(absl::string_view url, const AVCodecContext* codec);
+
+		//! Create the format context and a video stream without parameters
+		void createStream(absl::string_view url);
+
+		//! Write the container header
+		void writeHeader(const Mp4Options& mp4);
+
+		//! Release the format context and the IO context
+		//! \returns false if flushing the IO context or closing the output failed
+		bool destroy();
+
+		//! Container format
+		OutputFormat _format;
+
+		//! Hold the formating of the IO container
+		AVFormatContext* _fmtCtx{nullptr};
+
+		//! Recording stream
+		AVStream* _stream{nullptr};
+
+		//! Sink receiving the output if not writing to a file
+		std::shared_ptr<OutputSink> _sink;
+	};
+}}}
@@ -0,0 +1,55 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Memory layouts of images passed to the recorder
+	enum class PixelFormat
+	{
+		//! Planar YUV 4:2:0, separate Y, U and V planes
+		Yuv420P,
+
+		//! Semi-planar YUV 4:2:0, Y plane and interleaved UV plane
+		Nv12,
+
+		//! Packed 8-bit RGB
+		Rgb24,
+
+		//! Packed 8-bit BGR
+		Bgr24,
+
+		//! Packed 8-bit BGR with alpha (or padding) byte
+		Bgra
+	};
+
+	//! Colour matrix used to convert RGB to YUV (limited range)
+	enum class ColorMatrix
+	{
+		//! ITU-R BT.601, standard definition
+		Bt601,
+
+		//! ITU-R BT.709, high definition
+		Bt709
+	};
+}}}
@@ -22,9 +22,24 @@
  */
 #include "recorder.h"
 
+// VCL
+#include "encoderregistry.h"
+#include "frameconverter.h"
+#include "filewriter.h"
+#include "framepool.h"
+#include "muxer.h"
+#include "scheduler.h"
+#include "sink.h"
+#include "staticframedetector.h"
+#include "threadaffinity.h"
+
 // C++ standard library
+#include <algorithm>
 #include <exception>
+#include <functional>
+#include <initializer_list>
 #include <iostream>
+#include <string>
 
 extern "C"
 {
@@ -38,351 +53,1710 @@ extern "C"
 
 namespace Vcl { namespace Graphics { namespace Recorder
 {
-	Recorder::Recorder(OutputFormat out_fmt, CodecType codec)
+	namespace
 	{
-		_fmtCtx = avformat_alloc_context();
-		if (_fmtCtx == nullptr) {
-			throw std::domain_error("Cannot allocate AVFormatContext");
+		//! Encoder parameters of a profile
+		struct ProfileDefaults
+		{
+			int64_t bit_rate;
+			int gop_size;
+			int max_b_frames;
+			int quality;
+			const char* x264_preset;
+			const char* nvenc_preset;
+			const char* qsv_preset;
+			bool zero_latency;
+			const char* vpx_deadline;
+			int vpx_cpu_used;
+			int aom_cpu_used;
+			int ffv1_context;
+		};
+
+		const ProfileDefaults& profileDefaults(EncoderProfile profile)
+		{
+			static const ProfileDefaults realtime{ 4000000, 60, 0, 23, "ultrafast", "llhp", "veryfast", true, "realtime", 8, 8, 0 };
+			static const ProfileDefaults balanced{ 2000000, 60, 1, 18, "medium", "medium", "medium", false, "good", 4, 4, 0 };
+			static const ProfileDefaults archive{ 400000, 12, 1, 12, "slow", "slow", "slow", false, "good", 1, 2, 1 };
+
+			switch (profile)
+			{
+			case EncoderProfile::Realtime:
+				return realtime;
+			case EncoderProfile::Balanced:
+				return balanced;
+			case EncoderProfile::Archive:
+				return archive;
+			default:
+				throw std::domain_error("Invalid encoder profile");
+			}
+		}
+
+		AVCodecID codecId(CodecType codec_cfg)
+		{
+			switch (codec_cfg)
+			{
+			case CodecType::H264:
+				return AV_CODEC_ID_H264;
+			case CodecType::Hevc:
+				return AV_CODEC_ID_HEVC;
+			case CodecType::Vp9:
+				return AV_CODEC_ID_VP9;
+			case CodecType::Av1:
+				return AV_CODEC_ID_AV1;
+			case CodecType::Ffv1:
+				return AV_CODEC_ID_FFV1;
+			default:
+				throw std::domain_error("Invalid codec definition");
+			}
+		}
+
+		//! Allocate the context configuring an encoder
+		AVCodecContext* allocateCodecContext(const AVCodec* codec)
+		{
+			AVCodecContext* codec_ctx = avcodec_alloc_context3(codec);
+			if (!codec_ctx)
+				throw std::runtime_error("Allocating codec context failed");
+
+			codec_ctx->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_S16;
+			return codec_ctx;
+		}
+
+		//! Planes of a frame owned by the caller
+		//! Each plane is referenced by its own buffer. The caller is notified
+		//! once the last of them is released.
+		struct ExternalFrame
+		{
+			std::function<void()> release;
+			std::atomic<int> references;
+		};
+
+		void releasePlane(void* opaque, uint8_t* /* data */)
+		{
+			auto frame = static_cast<ExternalFrame*>(opaque);
+			if (frame->references.fetch_sub(1) == 1)
+			{
+				if (frame->release)
+					frame->release();
+				delete frame;
+			}
+		}
+
+		//! Time base of the timestamps passed to the encoder
+		AVRational codecTimeBase(FrameTiming timing, unsigned int frame_rate)
+		{
+			// Variable timing stores the timestamps of the caller in microseconds
+			if (timing == FrameTiming::Variable)
+				return { 1, 1000000 };
+			else
+				return { 1, static_cast<int>(frame_rate) };
 		}
-		_fmtCtx->pb = nullptr;
+	}
+
+	Recorder::Recorder(OutputFormat out_fmt, CodecType codec)
+	: Recorder(out_fmt, codec, absl::string_view{})
+	{
+	}
+
+	Recorder::Recorder(OutputFormat out_fmt, CodecType codec, EncoderSettings settings)
+	: Recorder(out_fmt, codec, absl::string_view{})
+	{
+		_encoderSettings = std::move(settings);
+	}
 
+	Recorder::Recorder(OutputFormat out_fmt, CodecType codec, absl::string_view encoder)
+	{
 		// Create and configure the output container
-		createOutputFormat(out_fmt, _fmtCtx);
+		_outputFormat = out_fmt;
+		_muxer = std::make_unique<Muxer>(out_fmt);
+		_writerCounters = std::make_shared<WriterCounters>();
 
-		// Create the video recording stream
-		if (!(_videoStream = avformat_new_stream(_fmtCtx, nullptr)))
-			throw std::runtime_error("Failed creating recording stream");
+		std::tie(_codec, _codecCtx) = createCodec(codec, encoder);
+		_codecType = codec;
 
-		std::tie(_codec, _codecCtx) = createCodec(codec);
-		configureH264();
+		_converter = std::make_unique<FrameConverter>();
+		configureColorSpace();
 	}
 	Recorder::~Recorder()
 	{
 		close();
 
 		avcodec_free_context(&_codecCtx);
-		avformat_free_context(_fmtCtx);
 	}
 
-	void Recorder::open(absl::string_view sink_name, unsigned int width, unsigned int height, unsigned int frame_rate)
+	void Recorder::setAsyncEncoding(bool enable, unsigned int queue_size)
 	{
-		int av_err = -1;
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the encoding mode while the video is open");
 
+		_async = enable;
+		_queueSize = queue_size > 0 ? queue_size : 1;
+	}
+
+	void Recorder::setBufferedWriter(bool enable, FileWriterOptions options)
+	{
 		if (_isOpen)
-			throw std::runtime_error("Video is already open");
+			throw std::runtime_error("Cannot change the writer while the video is open");
 
-		if (_fmtCtx->pb != nullptr)
-		{
-			avio_close(_fmtCtx->pb);
-			_fmtCtx->pb = nullptr;
-		}
+		_bufferedWriter = enable;
+		_writerOptions = options;
+	}
 
-		// Set the output name
-		const auto sink_name_len = sink_name.size() + 1;
-		_fmtCtx->url = static_cast<char*>(av_malloc(sink_name_len));
-		memset(_fmtCtx->url, 0, sink_name_len);
-		sink_name.copy(_fmtCtx->url, sink_name.size());
+	void Recorder::setStaticFrameDetection(bool enable, unsigned int max_skipped)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the static frame detection while the video is open");
 
-		_videoStream->time_base = { 1, static_cast<int>(frame_rate) };
+		if (enable)
+			_staticFrameDetector = std::make_unique<StaticFrameDetector>();
+		else
+			_staticFrameDetector.reset();
+		_maxSkippedFrames = max_skipped;
+	}
 
-		_codecCtx->width = width;
-		_codecCtx->height = height;
-		_codecCtx->time_base = _videoStream->time_base;
+	void Recorder::setFrameTiming(FrameTiming timing)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the frame timing while the video is open");
 
-		// Open the codec and prepare for using it
-		av_err = avcodec_open2(_codecCtx, _codec, nullptr);
-		if (av_err < 0)
-			throw std::runtime_error("Opening codec failed");
+		_frameTiming = timing;
+	}
 
-		// Transfer context to stream
-		av_err = avcodec_parameters_from_context(_videoStream->codecpar, _codecCtx);
-		if (av_err < 0)
-			throw std::runtime_error("Extracting codec parameters failed");
+	void Recorder::setOverflowPolicy(OverflowPolicy policy)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the overflow policy while the video is open");
 
-		// Debug output
-		av_dump_format(_fmtCtx, 0, _fmtCtx->url, 1);
+		_overflowPolicy = policy;
+	}
 
-		av_err = avio_open(&_fmtCtx->pb, _fmtCtx->url, AVIO_FLAG_WRITE);
-		if (av_err < 0)
-			throw std::runtime_error("Opening audio failed");
+	void Recorder::setScheduler(std::shared_ptr<Scheduler> scheduler)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the scheduler while the video is open");
+
+		_scheduler = std::move(scheduler);
+	}
 
-		AVDictionary* fmt_opts = nullptr;
+	bool Recorder::canAccept() const
+	{
+		if (!_isOpen || !_async)
+			return _isOpen;
 
-		// Reference for AvFormatContext options: https://ffmpeg.org/doxygen/2.8/movenc_8c_source.html
-		// Set format's privater options, to be passed to avformat_write_header()
-		av_dict_set(&fmt_opts, "movflags", "faststart", 0);
+		return !_pipelineFailed && _frameQueue->size() < _frameQueue->capacity();
+	}
 
-		// default brand is "isom", which fails on some devices
-		av_dict_set(&fmt_opts, "brand", "mp42", 0);
+	void Recorder::setColorMatrix(ColorMatrix matrix)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the colour matrix while the video is open");
 
-		av_err = avformat_write_header(_fmtCtx, &fmt_opts);
-		if (av_err < 0) {
-			if (av_err == AVERROR_INVALIDDATA)
-				throw std::runtime_error("Writing AV header failed: Invalid data");
-			else
-				throw std::runtime_error("Writing AV header failed");
-		}
+		_colorMatrix = matrix;
+		configureColorSpace();
+	}
 
-		_isOpen = true;
-		_frames = 0;
+	void Recorder::setConversionSlices(unsigned int slices)
+	{
+		_converter->setSliceCount(slices);
+	}
 
-		// Prepare a frame to be used to compress frames
-		_processing_frame = av_frame_alloc();
-		if (!_processing_frame)
-			throw std::runtime_error("Allocating processing frame failed");
+	unsigned int Recorder::conversionSlices() const
+	{
+		return _converter->sliceCount();
+	}
+
+	void Recorder::setEncoderThreads(EncoderThreads threads)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the encoder threading while the video is open");
 
-		// Make sure the encoder doesn't keep ref to this frame as we'll modify it.
-		av_frame_make_writable(_processing_frame);
-		_processing_frame->format = _codecCtx->pix_fmt;
-		_processing_frame->width = _codecCtx->width;
-		_processing_frame->height = _codecCtx->height;
-		av_frame_get_buffer(_processing_frame, 32);
+		_encoderThreads = std::move(threads);
+	}
 
-		//av_err = av_image_alloc(_processing_frame->data, _processing_frame->linesize, _codecCtx->width, _codecCtx->height, _codecCtx->pix_fmt, 32);
-		if (av_err < 0)
-			throw std::runtime_error("Allocating memory for processing frame failed");
+	EncoderThreads Recorder::encoderThreads() const
+	{
+		if (!_isOpen)
+			return _encoderThreads;
+
+		EncoderThreads effective;
+		effective.count = static_cast<unsigned int>(std::max(_codecCtx->thread_count, 0));
+		effective.affinity = _encoderThreads.affinity;
+
+		// Threading implemented by libavcodec is reported directly. Encoders
+		// managing their own threads (e.g. libx264) pick frame threading
+		// unless only slice threading is requested.
+		if (_codecCtx->active_thread_type & FF_THREAD_FRAME)
+			effective.model = ThreadingModel::Frame;
+		else if (_codecCtx->active_thread_type & FF_THREAD_SLICE)
+			effective.model = ThreadingModel::Slice;
+		else if (_codec->capabilities & AV_CODEC_CAP_AUTO_THREADS)
+			effective.model = _codecCtx->thread_type == FF_THREAD_SLICE ? ThreadingModel::Slice : ThreadingModel::Frame;
+		else
+			effective.model = ThreadingModel::Auto;
+
+		return effective;
+	}
+
+	void Recorder::setStatsEnabled(bool enable)
+	{
+		_statsEnabled.store(enable, std::memory_order_relaxed);
+	}
+
+	RecorderStats Recorder::stats() const
+	{
+		RecorderStats stats;
+		for (size_t s = 0; s < StageCount; s++)
+			stats.stages[s] = _stageTimes[s].summary();
+		stats.packets = _packetsWritten.load(std::memory_order_relaxed);
+		stats.bytes_written = _bytesWritten.load(std::memory_order_relaxed);
+		stats.allocations = _poolAllocations;
+		stats.writer = _writerCounters->snapshot();
+		stats.skipped_frames = _skippedFrames.load(std::memory_order_relaxed);
+		stats.dropped_frames = _droppedFrames.load(std::memory_order_relaxed);
+		stats.duplicated_frames = _duplicatedFrames.load(std::memory_order_relaxed);
+		stats.overflow_frames = _overflowFrames.load(std::memory_order_relaxed);
+		stats.overflow_packets = _overflowPackets.load(std::memory_order_relaxed);
+		stats.failed_outputs = _failedOutputs.load(std::memory_order_relaxed);
+		if (_framePool)
+			stats.allocations += _framePool->allocations();
+		if (_packetPool)
+			stats.allocations += _packetPool->allocations();
+
+		return stats;
+	}
+
+	void Recorder::resetStats()
+	{
+		for (auto& histogram : _stageTimes)
+			histogram.reset();
+		_packetsWritten = 0;
+		_bytesWritten = 0;
+		_writerCounters->reset();
+		_skippedFrames = 0;
+		_droppedFrames = 0;
+		_duplicatedFrames = 0;
+		_overflowFrames = 0;
+		_overflowPackets = 0;
+		_failedOutputs = 0;
+		_poolAllocations = 0;
+		if (_framePool)
+			_poolAllocations -= _framePool->allocations();
+		if (_packetPool)
+			_poolAllocations -= _packetPool->allocations();
+	}
+
+	void Recorder::open(absl::string_view sink_name, unsigned int width, unsigned int height, unsigned int frame_rate)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Video is already open");
+
+		_replay.reset();
+		openCodec(width, height, frame_rate);
+		openFile(*_muxer, sink_name, _mp4Options);
+		openOutputs();
+		startPipeline();
+	}
+
+	void Recorder::open(std::shared_ptr<OutputSink> sink, unsigned int width, unsigned int height, unsigned int frame_rate)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Video is already open");
+		if (!sink)
+			throw std::domain_error("Invalid output sink");
+
+		_replay.reset();
+		openCodec(width, height, frame_rate);
+		_muxer->open(std::move(sink), _codecCtx, _mp4Options);
+		openOutputs();
+		startPipeline();
+	}
+
+	void Recorder::open(const SegmentOptions& segments, unsigned int width, unsigned int height, unsigned int frame_rate)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Video is already open");
+
+		std::array<char, 1024> path;
+		if (av_get_frame_filename2(path.data(), static_cast<int>(path.size()), segments.pattern.c_str(), 0, 0) < 0)
+			throw std::domain_error("Segment pattern requires a single index placeholder");
+
+		_segments = segments;
+		_segmentIndex = segments.start_index;
+		_segmentEmpty = true;
+
+		_replay.reset();
+		openCodec(width, height, frame_rate);
+
+		openFile(*_muxer, segmentPath(_segmentIndex), segmentMp4Options());
+		openOutputs();
+		_segmented = true;
+		startPipeline();
 	}
 
-	void Recorder::close()
+	void Recorder::open(const ReplayOptions& replay, unsigned int width, unsigned int height, unsigned int frame_rate)
 	{
 		if (_isOpen)
+			throw std::runtime_error("Video is already open");
+		if (replay.max_bytes == 0)
+			throw std::domain_error("Replay requires a byte budget");
+		if (!_outputs.empty())
+			throw std::runtime_error("Replay mode does not support additional outputs");
+
+		const int64_t duration = av_rescale_q(replay.duration.count(), { 1, 1000 }, codecTimeBase(_frameTiming, frame_rate));
+		_replay = std::make_unique<ReplayBuffer>(replay.max_bytes, duration);
+
+		openCodec(width, height, frame_rate);
+		startPipeline();
+	}
+
+	size_t Recorder::dumpReplay(absl::string_view path, OutputFormat fmt) const
+	{
+		if (!_replay)
+			throw std::runtime_error("Recorder is not in replay mode");
+		if (avformat_query_codec(Muxer::outputFormat(fmt), _codecCtx->codec_id, FF_COMPLIANCE_NORMAL) != 1)
+			throw std::domain_error("Container does not support the codec");
+		if (_frameTiming == FrameTiming::Variable && !(Muxer::outputFormat(fmt)->flags & AVFMT_VARIABLE_FPS))
+			throw std::domain_error("Container does not support variable frame timing");
+
+		std::vector<AVPacket*> packets;
+		_replay->snapshot(packets);
+		auto free_packets = [&packets]()
 		{
-			write(nullptr);
-			av_write_trailer(_fmtCtx);
-			avio_close(_fmtCtx->pb);
-			_fmtCtx->pb = nullptr;
-		}
+			for (auto& pkt : packets)
+				av_packet_free(&pkt);
+		};
 
-		if (_processing_frame)
+		// The output starts at the first kept packet
+		const int64_t start = packets.empty() ? 0 : packets.front()->dts;
+
+		size_t written = 0;
+		try
 		{
-			//av_freep(&_processing_frame->data[0]);
-			av_frame_free(&_processing_frame);
+			Muxer muxer{ fmt };
+			muxer.open(path, _codecCtx, _mp4Options);
+			for (AVPacket* pkt : packets)
+			{
+				pkt->pts -= start;
+				pkt->dts -= start;
+				if (!muxer.write(pkt, _codecCtx->time_base))
+					throw std::runtime_error("Writing replay packet failed");
+				written++;
+			}
+			if (!muxer.close())
+				throw std::runtime_error("Closing replay file failed");
+		}
+		catch (...)
+		{
+			free_packets();
+			throw;
 		}
+		free_packets();
 
-		_isOpen = false;
+		return written;
 	}
 
-	void Recorder::createOutputFormat(OutputFormat fmt, gsl::not_null<AVFormatContext*> ctx) const
+	void Recorder::replayPackets(std::vector<AVPacket*>& packets) const
 	{
-		AVOutputFormat* out_fmt = nullptr;
-		switch (fmt)
-		{
-		case OutputFormat::Avi:
-			out_fmt = av_guess_format("avi", nullptr, nullptr);
-			break;
-		case OutputFormat::Mkv:
-			out_fmt = av_guess_format("matroska", nullptr, nullptr);
-			break;
-		case OutputFormat::Mp4:
-			out_fmt = av_guess_format("mp4", nullptr, nullptr);
-			break;
-		default:
-			throw std::domain_error("Invalid output format definition");
-		}
+		if (!_replay)
+			throw std::runtime_error("Recorder is not in replay mode");
 
-		if (out_fmt == nullptr)
-			throw std::runtime_error("Unable to allocate AVOutputFormat");
-		_fmtCtx->oformat = out_fmt;
+		_replay->snapshot(packets);
 	}
 
-	std::pair<AVCodec*, AVCodecContext*> Recorder::createCodec(CodecType codec_cfg) const
+	void Recorder::streamParameters(AVCodecParameters* par) const
 	{
-		AVCodec* codec = nullptr;
-		AVCodecContext* codec_ctx = nullptr;
-		if (codec_cfg == CodecType::H264)
-		{
-			// List of available hardware encoders in FFmpeg 4
-			// https://stackoverflow.com/a/50703794
-			// * h264_amf to access AMD gpu
-			// * h264_nvenc use nvidia gpu cards
-			// * h264_omx raspberry pi encoder
-			// * h264_qsv use Intel Quick Sync Video (hardware embedded in modern Intel CPU)
-			// * h264_v4l2m2m use V4L2 Linux kernel api to access hardware codecs
-			// * h264_vaapi use VAAPI which is another abstraction API to access video acceleration hardware
-			// * h264_videotoolbox use videotoolbox an API to access hardware on OS X
-			codec = avcodec_find_encoder_by_name("h264_nvenc");
-			if (codec == nullptr)
-				codec = avcodec_find_encoder_by_name("h264_qsv");
-			if (codec == nullptr)
-				codec = avcodec_find_encoder_by_name("libopenh264");
-			if (codec == nullptr)
-				codec = avcodec_find_encoder_by_name("libx264");
-		}
+		if (avcodec_parameters_from_context(par, _codecCtx) < 0)
+			throw std::runtime_error("Extracting codec parameters failed");
+	}
+
+	TimeBase Recorder::timeBase() const
+	{
+		return { _codecCtx->time_base.num, _codecCtx->time_base.den };
+	}
+
+	void Recorder::openFile(Muxer& muxer, absl::string_view path, const Mp4Options& mp4)
+	{
+		if (_bufferedWriter)
+			muxer.open(std::make_shared<FileWriter>(path, _writerOptions, _writerCounters), _codecCtx, mp4);
 		else
-			throw std::domain_error("Invalid codec definition");
+			muxer.open(path, _codecCtx, mp4);
+	}
 
-		if (!codec)
-			throw std::runtime_error("Encoder for requested codec not found");
-		codec_ctx = avcodec_alloc_context3(codec);
-		if (_fmtCtx->oformat->flags & AVFMT_GLOBALHEADER)
-			codec_ctx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+	size_t Recorder::addOutput(OutputFormat fmt, absl::string_view url)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot add outputs while the video is open");
+		if (avformat_query_codec(Muxer::outputFormat(fmt), _codecCtx->codec_id, FF_COMPLIANCE_NORMAL) != 1)
+			throw std::domain_error("Codec is not supported by the output format");
 
-		codec_ctx->sample_fmt = codec->sample_fmts ? codec->sample_fmts[0] : AV_SAMPLE_FMT_S16;
+		auto output = std::make_unique<TeeOutput>();
+		output->format = fmt;
+		output->url = std::string{ url };
+		output->muxer = std::make_unique<Muxer>(fmt);
+		_outputs.emplace_back(std::move(output));
 
-		return {codec, codec_ctx};
+		return _outputs.size() - 1;
 	}
 
-	void Recorder::configureH264()
+	size_t Recorder::addOutput(OutputFormat fmt, std::shared_ptr<OutputSink> sink)
 	{
-		int av_err = -1;
+		if (!sink)
+			throw std::domain_error("Invalid output sink");
 
-		_codecCtx->bit_rate = 400000;
-		_codecCtx->gop_size = 12;
-		_codecCtx->level = 31;
-		_codecCtx->max_b_frames = 1;
+		const size_t index = addOutput(fmt, absl::string_view{});
+		_outputs[index]->sink = std::move(sink);
 
-		// libx264 specific setting
-		if (strcmp(_codecCtx->codec->name, "libx264") == 0)
-		{
-			_codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
-			av_err = av_opt_set(_codecCtx->priv_data, "crf", "12", 0);
-			if (av_err < 0)
-				throw std::runtime_error("AV set option crf");
+		return index;
+	}
+
+	void Recorder::clearOutputs()
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot remove outputs while the video is open");
 
-			av_err = av_opt_set(_codecCtx->priv_data, "profile", "main", 0);
-			if (av_err < 0)
-				throw std::runtime_error("AV set option profile");
+		_outputs.clear();
+	}
 
-			av_err = av_opt_set(_codecCtx->priv_data, "preset", "slow", 0);
-			if (av_err < 0)
-				throw std::runtime_error("AV set option preset");
+	bool Recorder::isOutputFailed(size_t index) const
+	{
+		return _outputs.at(index)->failed;
+	}
 
-			// Disable b-pyramid. CLI options for this is "-b-pyramid 0"
-			// Quicktime (ie. iOS) doesn't support this option
-			av_err = av_opt_set(_codecCtx->priv_data, "b-pyramid", "0", 0);
-			if (av_err < 0)
-				throw std::runtime_error("AV set option b-pyramid");
-		}
-		else if (strcmp(_codecCtx->codec->name, "libopenh264") == 0)
+	void Recorder::openOutputs()
+	{
+		if (_outputs.empty())
+			return;
+
+		_teePacket = av_packet_alloc();
+		if (!_teePacket)
+			throw std::runtime_error("Allocating packet failed");
+
+		// An output which cannot be created does not prevent the recording
+		for (auto& output : _outputs)
 		{
-			_codecCtx->pix_fmt = AV_PIX_FMT_YUV420P;
-			av_err = av_opt_set(_codecCtx->priv_data, "profile", "baseline", AV_OPT_SEARCH_CHILDREN);
-			if (av_err < 0)
-				throw std::runtime_error("AV set option profile");
+			output->failed = false;
+			try
+			{
+				if (output->sink)
+					output->muxer->open(output->sink, _codecCtx, _mp4Options);
+				else
+					openFile(*output->muxer, output->url, _mp4Options);
+			}
+			catch (const std::exception&)
+			{
+				output->failed = true;
+				_failedOutputs.fetch_add(1, std::memory_order_relaxed);
+			}
 		}
-		else if (strcmp(_codecCtx->codec->name, "h264_qsv") == 0)
+	}
+
+	void Recorder::closeOutputs()
+	{
+		for (auto& output : _outputs)
 		{
-			_codecCtx->pix_fmt = AV_PIX_FMT_NV12;
-			av_err = av_opt_set(_codecCtx->priv_data, "profile", "baseline", AV_OPT_SEARCH_CHILDREN);
-			if (av_err < 0)
-				throw std::runtime_error("AV set option profile");
+			// Outputs which failed before were closed when they failed
+			if (!output->muxer->close() && !output->failed)
+			{
+				output->failed = true;
+				_failedOutputs.fetch_add(1, std::memory_order_relaxed);
+			}
 		}
 
-		const uint8_t spspps[] =
-		{
-			0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x0a, 0xf8, 0x41, 0xa2,
-			0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x38, 0x80
-		};
+		if (_teePacket)
+			av_packet_free(&_teePacket);
+	}
 
-		_codecCtx->extradata = (uint8_t *)av_malloc(sizeof(uint8_t) * sizeof(spspps));
-		for (unsigned int index = 0; index < sizeof(spspps); index++)
+	void Recorder::writeOutputs(const AVPacket* pkt)
+	{
+		for (auto& output : _outputs)
 		{
-			_codecCtx->extradata[index] = spspps[index];
+			if (output->failed)
+				continue;
+
+			// Reference the encoded data instead of copying it. The muxer
+			// modifies the timestamps, thus each output needs its own packet.
+			const bool written = av_packet_ref(_teePacket, pkt) >= 0 && output->muxer->write(_teePacket, _codecCtx->time_base);
+			av_packet_unref(_teePacket);
+			if (!written)
+			{
+				// Finish the data written so far and continue with the other outputs
+				output->muxer->close();
+				output->failed = true;
+				_failedOutputs.fetch_add(1, std::memory_order_relaxed);
+			}
 		}
-		_codecCtx->extradata_size = (int)sizeof(spspps);
 	}
 
-	bool Recorder::write(gsl::span<const uint8_t> Y, gsl::span<const uint8_t> U, gsl::span<const uint8_t> V)
+	template<typename Predicate>
+	bool Recorder::anyOutputFormat(Predicate pred) const
 	{
-		_processing_frame->format = AV_PIX_FMT_YUV420P;
-		av_image_fill_arrays(_processing_frame->data, _processing_frame->linesize, nullptr, (AVPixelFormat)_processing_frame->format, _processing_frame->width, _processing_frame->height, 1);
-		_processing_frame->data[0] = const_cast<uint8_t*>(Y.data());
-		_processing_frame->data[1] = const_cast<uint8_t*>(U.data());
-		_processing_frame->data[2] = const_cast<uint8_t*>(V.data());
-		_processing_frame->pts = _frames++;
+		if (pred(Muxer::outputFormat(_outputFormat)))
+			return true;
 
-		return write(_processing_frame);
-	}
-	
-	bool Recorder::write(gsl::span<const uint8_t> Y, gsl::span<const std::array<uint8_t, 2>> UV)
-	{
-		_processing_frame->format = AV_PIX_FMT_NV12;
-		av_image_fill_arrays(_processing_frame->data, _processing_frame->linesize, nullptr, (AVPixelFormat)_processing_frame->format, _processing_frame->width, _processing_frame->height, 1);
-		_processing_frame->data[0] = const_cast<uint8_t*>(Y.data());
-		_processing_frame->data[1] = const_cast<uint8_t*>(UV.data()->data());
-		_processing_frame->pts = _frames++;
+		for (const auto& output : _outputs)
+		{
+			if (pred(Muxer::outputFormat(output->format)))
+				return true;
+		}
 
-		return write(_processing_frame);
+		return false;
 	}
 
-	bool Recorder::write(gsl::span<const std::array<uint8_t, 3>> rgb, unsigned int w, unsigned int h)
+	void Recorder::openCodec(unsigned int width, unsigned int height, unsigned int frame_rate)
 	{
-		using SwsContext = std::unique_ptr<SwsContext, void(*)(SwsContext*)>;
-		using ByteArray = std::unique_ptr<uint8_t, void(*)(void*)>;
+		int av_err = -1;
 
-		// Convert from RGB to YUV
-		const auto cw = _codecCtx->width;
-		const auto ch = _codecCtx->height;
-		auto sws_ctx = SwsContext(sws_getContext(
-			w,
-			h,
-			AV_PIX_FMT_BGR24,
-			cw,
-			ch,
-			_codecCtx->pix_fmt,
-			SWS_BICUBIC, NULL, NULL, NULL
-		), sws_freeContext);
-		const uint8_t* rgb24[3] = { rgb.data()->data(), 0, 0 };
-		int rgb24_stride[4] = { 3 * w, 0, 0, 0 };
+		// Containers with a constant frame rate cannot store arbitrary timestamps
+		if (_frameTiming == FrameTiming::Variable && !_replay && anyOutputFormat([](const AVOutputFormat* fmt) { return !(fmt->flags & AVFMT_VARIABLE_FPS); }))
+			throw std::domain_error("Container does not support variable frame timing");
 
-		if (_codecCtx->pix_fmt == AV_PIX_FMT_YUV420P)
+		// An opened encoder cannot be configured again. Later recordings
+		// start from a new context, such that changed settings apply.
+		if (avcodec_is_open(_codecCtx))
 		{
-			auto buffer = ByteArray(reinterpret_cast<uint8_t*>(malloc(rgb.size_bytes())), free);
-			uint8_t* yuv420p[3] = { buffer.get(), buffer.get() + cw*ch, buffer.get() + cw*ch + cw*ch/4 };
-			int yuv420p_stride[4] = { cw, cw/2, cw/2, 0 };
-			sws_scale(sws_ctx.get(), rgb24, rgb24_stride, 0, h, yuv420p, yuv420p_stride);
-
-			return write(gsl::make_span(yuv420p[0], cw*ch), gsl::make_span(yuv420p[1], cw*ch), gsl::make_span(yuv420p[2], cw*ch));
+			AVCodecContext* codec_ctx = allocateCodecContext(_codec);
+			avcodec_free_context(&_codecCtx);
+			_codecCtx = codec_ctx;
+			configureColorSpace();
 		}
-		else if (_codecCtx->pix_fmt == AV_PIX_FMT_NV12)
+
+		_codecCtx->width = width;
+		_codecCtx->height = height;
+		_codecCtx->time_base = codecTimeBase(_frameTiming, frame_rate);
+		_codecCtx->framerate = { static_cast<int>(frame_rate), 1 };
+		_frameDuration = av_rescale_q(1, { 1, static_cast<int>(frame_rate) }, _codecCtx->time_base);
+
+		// Apply the encoder settings
+		configureEncoder();
+
+		// Store the stream headers out-of-band if the container requires it.
+		// Replayed packets can be written to any container, which all
+		// support reading the headers from the codec parameters.
+		if (_replay || anyOutputFormat([](const AVOutputFormat* fmt) { return (fmt->flags & AVFMT_GLOBALHEADER) != 0; }))
+			_codecCtx->flags |= AV_CODEC_FLAG_GLOBAL_HEADER;
+		else
+			_codecCtx->flags &= ~AV_CODEC_FLAG_GLOBAL_HEADER;
+
+		// Configure the threading of the encoder. On a shared scheduler the
+		// recorders are encoded in parallel, thus additional encoder threads
+		// would only compete with the workers.
+		_codecCtx->thread_count = static_cast<int>(_encoderThreads.count);
+		if (_async && _scheduler && _encoderThreads.count == 0)
+			_codecCtx->thread_count = 1;
+		switch (_encoderThreads.model)
 		{
-			auto buffer = ByteArray(reinterpret_cast<uint8_t*>(malloc(rgb.size_bytes())), free);
-			uint8_t* nv12[3] = { buffer.get(), buffer.get() + cw*ch, nullptr };
-			int nv12_stride[4] = { cw, cw, 0, 0 };
-			sws_scale(sws_ctx.get(), rgb24, rgb24_stride, 0, h, nv12, nv12_stride);
+		case ThreadingModel::Frame:
+			_codecCtx->thread_type = FF_THREAD_FRAME;
+			break;
+		case ThreadingModel::Slice:
+			_codecCtx->thread_type = FF_THREAD_SLICE;
+			break;
+		default:
+			_codecCtx->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
+			break;
+		}
 
-			return write(gsl::make_span(nv12[0], cw*ch), gsl::make_span(reinterpret_cast<std::array<uint8_t, 2>*>(nv12[1]), cw*ch/4));
+		// Open the codec and prepare for using it. Encoders spawn their
+		// threads when opened, which then inherit the affinity.
+		{
+			ScopedThreadAffinity affinity{ _encoderThreads.affinity };
+			av_err = avcodec_open2(_codecCtx, _codec, nullptr);
 		}
-		return false;
+		if (av_err < 0)
+			throw std::runtime_error("Opening codec failed");
 	}
 
-	bool Recorder::write(AVFrame* frame)
+	void Recorder::startPipeline()
 	{
-		// Create a packet for the codec
-		AVPacket pkt = { 0 };
-		av_init_packet(&pkt);
-		av_packet_rescale_ts(&pkt, _codecCtx->time_base, _videoStream->time_base);
+		_isOpen = true;
+		_frames = 0;
+		_lastPts = 0;
+		_hasTimestampOrigin = false;
+		_consecutiveSkips = 0;
+		_lastSkipped = false;
+		if (_staticFrameDetector)
+			_staticFrameDetector->reset();
 
-		// Send the frame to the codec for encoding
-		int av_err = avcodec_send_frame(_codecCtx, frame);
-		if (av_err < 0)
-			return false;
+		// Recycle frames and packets for an allocation free steady state.
+		// Frames are held by the queue, the converter and the caller.
+		const size_t pool_capacity = _async ? _queueSize + 4 : 4;
+		_framePool = std::make_unique<FramePool>(_codecCtx->pix_fmt, _codecCtx->width, _codecCtx->height, pool_capacity);
+		_packetPool = std::make_unique<PacketPool>(_async ? 2 * _queueSize + 4 : 4);
+		_packet = av_packet_alloc();
+		if (!_packet)
+			throw std::runtime_error("Allocating packet failed");
 
-		for(;;)
-		{
-			// Query the codec for packets to be further processed and
-			// written to the output.
-			av_err = avcodec_receive_packet(_codecCtx, &pkt);
+		// Prepare a frame to be used to compress frames
+		_processing_frame = _framePool->get();
+		if (!_processing_frame)
+			throw std::runtime_error("Allocating memory for processing frame failed");
 
-			// Check if there is actually something to write:
-			// EAGAIN: No image ready to be processed
-			// EOF: The image queue is empty
-			if (av_err == AVERROR(EAGAIN) || av_err == AVERROR_EOF)
-				return true;
-			else if (av_err < 0)
-				return false;
+		// Prepare the frame wrapping the memory passed by the user
+		_input_frame = av_frame_alloc();
+		if (!_input_frame)
+			throw std::runtime_error("Allocating input frame failed");
+		_input_frame->width = _codecCtx->width;
+		_input_frame->height = _codecCtx->height;
 
-			av_packet_rescale_ts(&pkt, _codecCtx->time_base, _videoStream->time_base);
-			pkt.stream_index = _videoStream->index;
+		// Start the encoding pipeline
+		if (_async)
+		{
+			_pipelineFailed = false;
+			_frameQueue = std::make_unique<BoundedQueue<AVFrame*>>(_queueSize);
+			if (_scheduler)
+			{
+				// Encoding and muxing of a recorder are executed by the same
+				// task, which never blocks a worker on a full packet queue
+				_strand = _scheduler->createStrand();
+			}
+			else
+			{
+				_packetQueue = std::make_unique<BoundedQueue<AVPacket*>>(2 * _queueSize);
+				_encoderThread = std::thread{ [this]() { setThreadAffinity(_encoderThreads.affinity); encoderLoop(); } };
+				_muxerThread = std::thread{ [this]() { setThreadAffinity(_encoderThreads.affinity); muxerLoop(); } };
+			}
+		}
+	}
 
-			// Write the packet to the output
-			av_err = av_interleaved_write_frame(_fmtCtx, &pkt);
-			if (av_err < 0)
-				return false;
+	bool Recorder::close()
+	{
+		bool closed = true;
+		if (_isOpen)
+		{
+			// Repeat the last image if it was skipped, so that the recording
+			// keeps its duration
+			if (_lastSkipped)
+			{
+				writeView(_staticFrameDetector->previous(), _lastSkippedPts);
+				_lastSkipped = false;
+			}
 
-			av_packet_unref(&pkt);
+			if (_async)
+			{
+				// Drain the pipeline. The encoder thread flushes the codec
+				// once all queued frames are processed.
+				_frameQueue->close();
+				if (_strand)
+				{
+					_strand->post([this]()
+					{
+						if (!encode(nullptr))
+							_pipelineFailed = true;
+					});
+					_strand->drain();
+					_strand.reset();
+				}
+				else
+				{
+					_encoderThread.join();
+					_muxerThread.join();
+				}
+				_frameQueue.reset();
+				_packetQueue.reset();
+			}
+			else
+			{
+				encode(nullptr);
+			}
+			if (_segmented)
+			{
+				// Report the last segment, unless writing it failed
+				closed = _muxer->isOpen() && finalizeSegment();
+				_segmented = false;
+			}
+			else
+			{
+				closed = _muxer->close();
+			}
+			closeOutputs();
+		}
+
+		if (_processing_frame)
+		{
+			av_frame_free(&_processing_frame);
+		}
+		if (_input_frame)
+		{
+			av_frame_free(&_input_frame);
+		}
+		if (_previousFrame)
+		{
+			av_frame_free(&_previousFrame);
+		}
+		if (_packet)
+		{
+			av_packet_free(&_packet);
+		}
+
+		// Keep the number of allocations for the statistics
+		if (_framePool)
+			_poolAllocations += _framePool->allocations();
+		if (_packetPool)
+			_poolAllocations += _packetPool->allocations();
+		_framePool.reset();
+		_packetPool.reset();
+
+		_isOpen = false;
+		return closed;
+	}
+
+	std::vector<std::string> Recorder::availableEncoders(CodecType codec_cfg)
+	{
+		std::vector<std::string> encoders;
+		for (const auto& encoder : EncoderRegistry::instance().encoders(codec_cfg))
+		{
+			if (encoder.usable)
+				encoders.emplace_back(encoder.name);
+		}
+		return encoders;
+	}
+
+	const char* Recorder::encoderName() const
+	{
+		return _codec->name;
+	}
+
+	std::pair<AVCodec*, AVCodecContext*> Recorder::createCodec(CodecType codec_cfg, absl::string_view encoder) const
+	{
+		AVCodec* codec = nullptr;
+		AVCodecContext* codec_ctx = nullptr;
+
+		// Check if the container can store the codec
+		const AVOutputFormat* out_fmt = Muxer::outputFormat(_outputFormat);
+		if (avformat_query_codec(out_fmt, codecId(codec_cfg), FF_COMPLIANCE_NORMAL) != 1)
+			throw std::domain_error("Codec is not supported by the output format");
+
+		if (!encoder.empty())
+		{
+			codec = avcodec_find_encoder_by_name(std::string{ encoder }.c_str());
+			if (codec && codec->id != codecId(codec_cfg))
+				throw std::domain_error("Encoder does not implement the requested codec");
+		}
+		else
+		{
+			// Only select encoders which could be opened before, thus
+			// unavailable hardware is never picked
+			const std::string name = EncoderRegistry::instance().preferredEncoder(codec_cfg);
+			if (!name.empty())
+				codec = avcodec_find_encoder_by_name(name.c_str());
+		}
+
+		if (!codec)
+			throw std::runtime_error("Encoder for requested codec not found");
+		codec_ctx = allocateCodecContext(codec);
+
+		return {codec, codec_ctx};
+	}
+
+	void Recorder::setEncoderSettings(EncoderSettings settings)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the encoder settings while the video is open");
+
+		_encoderSettings = std::move(settings);
+	}
+
+	void Recorder::setMp4Options(Mp4Options options)
+	{
+		if (_isOpen)
+			throw std::runtime_error("Cannot change the MP4 options while the video is open");
+
+		_mp4Options = options;
+	}
+
+	void Recorder::configureEncoder()
+	{
+		const auto& profile = profileDefaults(_encoderSettings.profile);
+
+		// Settings shared by all encoders
+		_codecCtx->bit_rate = _encoderSettings.bit_rate.value_or(profile.bit_rate);
+		_codecCtx->gop_size = _encoderSettings.gop_size.value_or(profile.gop_size);
+		_codecCtx->max_b_frames = _encoderSettings.max_b_frames.value_or(profile.max_b_frames);
+		_codecCtx->pix_fmt = negotiatePixelFormat(_codec);
+		configureOpenRequirements(_codec, _codecCtx);
+
+		switch (_codecType)
+		{
+		case CodecType::H264:
+			configureH264();
+			break;
+		case CodecType::Hevc:
+			configureHevc();
+			break;
+		case CodecType::Vp9:
+			configureVp9();
+			break;
+		case CodecType::Av1:
+			configureAv1();
+			break;
+		case CodecType::Ffv1:
+			configureFfv1();
+			break;
+		}
+	}
+
+	void Recorder::configureH264()
+	{
+		const auto& profile = profileDefaults(_encoderSettings.profile);
+		const int quality = _encoderSettings.quality.value_or(profile.quality);
+
+		_codecCtx->level = 31;
+
+		// libx264 specific setting
+		if (strcmp(_codecCtx->codec->name, "libx264") == 0)
+		{
+			setCodecOption("crf", std::to_string(quality).c_str());
+			setCodecOption("profile", "main");
+			setCodecOption("preset", profile.x264_preset);
+			if (profile.zero_latency)
+				setCodecOption("tune", "zerolatency");
+
+			// Disable b-pyramid. CLI options for this is "-b-pyramid 0"
+			// Quicktime (ie. iOS) doesn't support this option
+			setCodecOption("b-pyramid", "0");
+		}
+		else if (strcmp(_codecCtx->codec->name, "libopenh264") == 0)
+		{
+			// Only supports rate control by bit rate
+			setCodecOption("profile", "baseline", AV_OPT_SEARCH_CHILDREN);
+		}
+		else if (strcmp(_codecCtx->codec->name, "h264_nvenc") == 0)
+		{
+			setCodecOption("preset", profile.nvenc_preset);
+			setCodecOption("cq", std::to_string(quality).c_str());
+			if (profile.zero_latency)
+				setCodecOption("zerolatency", "1");
+		}
+		else if (strcmp(_codecCtx->codec->name, "h264_qsv") == 0)
+		{
+			_codecCtx->global_quality = quality;
+			setCodecOption("profile", "baseline", AV_OPT_SEARCH_CHILDREN);
+			setCodecOption("preset", profile.qsv_preset);
+		}
+
+		const uint8_t spspps[] =
+		{
+			0x00, 0x00, 0x00, 0x01, 0x67, 0x42, 0x00, 0x0a, 0xf8, 0x41, 0xa2,
+			0x00, 0x00, 0x00, 0x01, 0x68, 0xce, 0x38, 0x80
+		};
+
+		av_freep(&_codecCtx->extradata);
+		_codecCtx->extradata = (uint8_t *)av_malloc(sizeof(uint8_t) * sizeof(spspps));
+		for (unsigned int index = 0; index < sizeof(spspps); index++)
+		{
+			_codecCtx->extradata[index] = spspps[index];
+		}
+		_codecCtx->extradata_size = (int)sizeof(spspps);
+	}
+
+	void Recorder::configureHevc()
+	{
+		const auto& profile = profileDefaults(_encoderSettings.profile);
+		const int quality = _encoderSettings.quality.value_or(profile.quality);
+
+		if (strcmp(_codecCtx->codec->name, "libx265") == 0)
+		{
+			setCodecOption("crf", std::to_string(quality).c_str());
+			setCodecOption("preset", profile.x264_preset);
+			if (profile.zero_latency)
+				setCodecOption("tune", "zerolatency");
+		}
+		else if (strcmp(_codecCtx->codec->name, "hevc_nvenc") == 0)
+		{
+			setCodecOption("preset", profile.nvenc_preset);
+			setCodecOption("cq", std::to_string(quality).c_str());
+			if (profile.zero_latency)
+				setCodecOption("zerolatency", "1");
+		}
+		else if (strcmp(_codecCtx->codec->name, "hevc_qsv") == 0)
+		{
+			_codecCtx->global_quality = quality;
+			setCodecOption("preset", profile.qsv_preset);
+		}
+	}
+
+	void Recorder::configureVp9()
+	{
+		const auto& profile = profileDefaults(_encoderSettings.profile);
+		const int quality = _encoderSettings.quality.value_or(profile.quality);
+
+		// libvpx specific setting. Other encoders (e.g. vp9_vaapi) only use
+		// the shared settings.
+		if (strcmp(_codecCtx->codec->name, "libvpx-vp9") == 0)
+		{
+			// libvpx only supports constant quality without a bit rate target.
+			// The quality scale ranges from 0 to 63.
+			if (!_encoderSettings.bit_rate)
+				_codecCtx->bit_rate = 0;
+			setCodecOption("crf", std::to_string(std::min(quality + quality / 4, 63)).c_str());
+			setCodecOption("deadline", profile.vpx_deadline);
+			setCodecOption("cpu-used", std::to_string(profile.vpx_cpu_used).c_str());
+			setCodecOption("row-mt", "1");
+			if (profile.zero_latency)
+				setCodecOption("lag-in-frames", "0");
+		}
+	}
+
+	void Recorder::configureAv1()
+	{
+		const auto& profile = profileDefaults(_encoderSettings.profile);
+		const int quality = _encoderSettings.quality.value_or(profile.quality);
+
+		// libaom specific setting
+		if (strcmp(_codecCtx->codec->name, "libaom-av1") == 0)
+		{
+			// Constant quality mode requires disabling the bit rate target.
+			// The quality scale ranges from 0 to 63.
+			if (!_encoderSettings.bit_rate)
+				_codecCtx->bit_rate = 0;
+			setCodecOption("crf", std::to_string(std::min(quality + quality / 4, 63)).c_str());
+			setCodecOption("cpu-used", std::to_string(profile.aom_cpu_used).c_str());
+			if (profile.zero_latency)
+				setCodecOption("lag-in-frames", "0");
+		}
+	}
+
+	void Recorder::configureFfv1()
+	{
+		const auto& profile = profileDefaults(_encoderSettings.profile);
+
+		// Lossless intra-only coding. Version 3 supports slice threading.
+		_codecCtx->gop_size = _encoderSettings.gop_size.value_or(1);
+		_codecCtx->max_b_frames = 0;
+		_codecCtx->level = 3;
+		setCodecOption("slicecrc", "1");
+		setCodecOption("context", std::to_string(profile.ffv1_context).c_str());
+	}
+
+	void Recorder::setCodecOption(const char* name, const char* value, int search_flags)
+	{
+		if (av_opt_set(_codecCtx->priv_data, name, value, search_flags) < 0)
+			throw std::runtime_error(std::string{ "AV set option " } + name);
+	}
+
+	void Recorder::configureColorSpace()
+	{
+		_converter->setColorMatrix(_colorMatrix);
+
+		_codecCtx->color_range = AVCOL_RANGE_MPEG;
+		if (_colorMatrix == ColorMatrix::Bt709)
+		{
+			_codecCtx->colorspace = AVCOL_SPC_BT709;
+			_codecCtx->color_primaries = AVCOL_PRI_BT709;
+			_codecCtx->color_trc = AVCOL_TRC_BT709;
+		}
+		else
+		{
+			_codecCtx->colorspace = AVCOL_SPC_SMPTE170M;
+			_codecCtx->color_primaries = AVCOL_PRI_SMPTE170M;
+			_codecCtx->color_trc = AVCOL_TRC_SMPTE170M;
+		}
+	}
+
+	bool Recorder::write(gsl::span<const uint8_t> Y, gsl::span<const uint8_t> U, gsl::span<const uint8_t> V)
+	{
+		const int w = _codecCtx->width;
+		const int chroma_w = (w + 1) / 2;
+		return write(FrameView::yuv420p(Y, w, U, chroma_w, V, chroma_w, _codecCtx->width, _codecCtx->height));
+	}
+	
+	bool Recorder::write(gsl::span<const uint8_t> Y, gsl::span<const std::array<uint8_t, 2>> UV)
+	{
+		const int w = _codecCtx->width;
+		const gsl::span<const uint8_t> uv{ UV.data()->data(), 2 * UV.size() };
+		return write(FrameView::nv12(Y, w, uv, 2 * ((w + 1) / 2), _codecCtx->width, _codecCtx->height));
+	}
+
+	bool Recorder::write(gsl::span<const std::array<uint8_t, 3>> rgb, unsigned int w, unsigned int h)
+	{
+		const gsl::span<const uint8_t> pixels{ rgb.data()->data(), 3 * rgb.size() };
+		return write(FrameView::packed(pixels, static_cast<int>(3 * w), PixelFormat::Bgr24, w, h));
+	}
+
+	bool Recorder::write(gsl::span<const std::array<uint8_t, 4>> bgra, unsigned int w, unsigned int h)
+	{
+		const gsl::span<const uint8_t> pixels{ bgra.data()->data(), 4 * bgra.size() };
+		return write(FrameView::packed(pixels, static_cast<int>(4 * w), PixelFormat::Bgra, w, h));
+	}
+
+	bool Recorder::write(gsl::span<const uint8_t> pixels, PixelFormat fmt, unsigned int w, unsigned int h)
+	{
+		const int row_bytes = FrameView::rowBytes(fmt, 0, w);
+		return write(FrameView::packed(pixels, row_bytes, fmt, w, h));
+	}
+
+	bool Recorder::write(const FrameView& view)
+	{
+		view.validate();
+
+		const int64_t pts = nextPts();
+		advanceTo(pts);
+		if (skipUnchanged(view, pts))
+			return true;
+
+		return writeView(view, pts);
+	}
+
+	bool Recorder::write(const FrameView& view, std::function<void()> release)
+	{
+		view.validate();
+
+		const int64_t pts = nextPts();
+		advanceTo(pts);
+		if (skipUnchanged(view, pts))
+		{
+			if (release)
+				release();
+			return true;
+		}
+
+		return writeView(view, std::move(release), pts);
+	}
+
+	bool Recorder::write(const FrameView& view, std::chrono::microseconds timestamp)
+	{
+		view.validate();
+
+		int64_t pts = 0;
+		const auto schedule = scheduleTimestamp(timestamp, pts);
+		if (schedule != Schedule::Write)
+			return schedule == Schedule::Drop;
+
+		advanceTo(pts);
+		if (skipUnchanged(view, pts))
+			return true;
+
+		return writeRetained(view, pts);
+	}
+
+	bool Recorder::write(const FrameView& view, std::chrono::steady_clock::time_point time)
+	{
+		return write(view, std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()));
+	}
+
+	bool Recorder::write(const FrameView& view, std::function<void()> release, std::chrono::microseconds timestamp)
+	{
+		view.validate();
+
+		int64_t pts = 0;
+		const auto schedule = scheduleTimestamp(timestamp, pts);
+		if (schedule != Schedule::Write)
+		{
+			if (release)
+				release();
+			return schedule == Schedule::Drop;
+		}
+
+		advanceTo(pts);
+		if (skipUnchanged(view, pts))
+		{
+			if (release)
+				release();
+			return true;
+		}
+
+		// The retained copy replaces the reference to the caller's image
+		if (_frameTiming == FrameTiming::Constant && !_staticFrameDetector)
+		{
+			const bool written = writeRetained(view, pts);
+			if (release)
+				release();
+			return written;
+		}
+
+		return writeView(view, std::move(release), pts);
+	}
+
+	int64_t Recorder::nextPts() const
+	{
+		return _frames == 0 ? 0 : _lastPts + _frameDuration;
+	}
+
+	void Recorder::advanceTo(int64_t pts)
+	{
+		_lastPts = pts;
+		_frames++;
+	}
+
+	Recorder::Schedule Recorder::scheduleTimestamp(std::chrono::microseconds timestamp, int64_t& pts)
+	{
+		// The recording starts with the first timestamp
+		if (!_hasTimestampOrigin)
+		{
+			_timestampOrigin = timestamp;
+			_hasTimestampOrigin = true;
+		}
+		pts = av_rescale_q((timestamp - _timestampOrigin).count(), { 1, 1000000 }, _codecCtx->time_base);
+
+		// Timestamps need to increase strictly. With constant timing,
+		// all but the first image of a frame interval are dropped.
+		if (_frames > 0 && pts <= _lastPts)
+		{
+			_droppedFrames.fetch_add(1, std::memory_order_relaxed);
+			return Schedule::Drop;
+		}
+
+		// Repeat the previous image for the frame intervals without image
+		if (_frameTiming == FrameTiming::Constant && _frames > 0)
+		{
+			for (int64_t missed = nextPts(); missed < pts; missed += _frameDuration)
+			{
+				advanceTo(missed);
+				if (!repeatPrevious(missed))
+					return Schedule::Failed;
+			}
+		}
+
+		return Schedule::Write;
+	}
+
+	bool Recorder::skipUnchanged(const FrameView& view, int64_t pts)
+	{
+		if (!_staticFrameDetector)
+			return false;
+
+		return skipFrame(_staticFrameDetector->isUnchanged(view), pts);
+	}
+
+	bool Recorder::skipFrame(bool unchanged, int64_t pts)
+	{
+		// Encode an unchanged image at least every 'max' frames
+		if (unchanged && (_maxSkippedFrames == 0 || _consecutiveSkips < _maxSkippedFrames))
+		{
+			_consecutiveSkips++;
+			_lastSkipped = true;
+			_lastSkippedPts = pts;
+			_skippedFrames.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+
+		_consecutiveSkips = 0;
+		_lastSkipped = false;
+		return false;
+	}
+
+	bool Recorder::repeatPrevious(int64_t pts)
+	{
+		// Repetitions dropped by the overflow policy are not counted
+		const uint64_t overflows = _overflowFrames.load(std::memory_order_relaxed);
+
+		bool written = false;
+		if (_staticFrameDetector)
+		{
+			// A repeated image is unchanged, and the detector keeps a copy of it
+			if (!_staticFrameDetector->hasPrevious() || skipFrame(true, pts))
+				return true;
+
+			written = writeView(_staticFrameDetector->previous(), pts);
+		}
+		else if (_previousFrame)
+		{
+			// The frame is replaced instead of modified while the encoder references it
+			_previousFrame->pts = pts;
+			written = write(_previousFrame);
+		}
+		else
+		{
+			// The previous image was written without timestamp
+			return true;
+		}
+
+		if (written && _overflowFrames.load(std::memory_order_relaxed) == overflows)
+			_duplicatedFrames.fetch_add(1, std::memory_order_relaxed);
+		return written;
+	}
+
+	bool Recorder::writeRetained(const FrameView& view, int64_t pts)
+	{
+		// With static frame detection, the detector keeps the previous image
+		if (_frameTiming != FrameTiming::Constant || _staticFrameDetector)
+			return writeView(view, pts);
+
+		// Replace the retained frame while the encoder still references it
+		if (!_previousFrame || !av_frame_is_writable(_previousFrame))
+		{
+			AVFrame* frame = _framePool->get();
+			if (!frame)
+				return false;
+
+			if (_previousFrame)
+				_framePool->put(_previousFrame);
+			_previousFrame = frame;
+		}
+
+		const uint8_t* src[4] = { nullptr, nullptr, nullptr, nullptr };
+		int src_stride[4] = { 0, 0, 0, 0 };
+		for (int p = 0; p < FrameView::planeCount(view.format); p++)
+		{
+			src[p] = view.planes[p].data();
+			src_stride[p] = view.strides[p];
+		}
+
+		bool converted = false;
+		{
+			ScopedStageTimer timer{ stageTimer(Stage::Convert) };
+			converted = _converter->convert(src, src_stride, toAVPixelFormat(view.format), static_cast<int>(view.width), static_cast<int>(view.height), _previousFrame);
+		}
+		if (!converted)
+		{
+			_framePool->put(_previousFrame);
+			_previousFrame = nullptr;
+			return false;
+		}
+		_previousFrame->pts = pts;
+
+		return write(_previousFrame);
+	}
+
+	bool Recorder::writeView(const FrameView& view, int64_t pts)
+	{
+		const uint8_t* src[4] = { nullptr, nullptr, nullptr, nullptr };
+		int src_stride[4] = { 0, 0, 0, 0 };
+		for (int p = 0; p < FrameView::planeCount(view.format); p++)
+		{
+			src[p] = view.planes[p].data();
+			src_stride[p] = view.strides[p];
+		}
+
+		// Images matching the encoder input are passed on without copy,
+		// using the strides of the caller
+		const AVPixelFormat fmt = toAVPixelFormat(view.format);
+		if (fmt == _codecCtx->pix_fmt &&
+			static_cast<int>(view.width) == _codecCtx->width &&
+			static_cast<int>(view.height) == _codecCtx->height)
+		{
+			_input_frame->format = fmt;
+			for (int p = 0; p < 4; p++)
+			{
+				_input_frame->data[p] = const_cast<uint8_t*>(src[p]);
+				_input_frame->linesize[p] = src_stride[p];
+			}
+			_input_frame->pts = pts;
+
+			return write(_input_frame);
+		}
+
+		return writeConverted(src, src_stride, fmt, static_cast<int>(view.width), static_cast<int>(view.height), pts);
+	}
+
+	bool Recorder::writeView(const FrameView& view, std::function<void()> release, int64_t pts)
+	{
+		const AVPixelFormat fmt = toAVPixelFormat(view.format);
+		const int nr_planes = FrameView::planeCount(view.format);
+		if (fmt != _codecCtx->pix_fmt ||
+			static_cast<int>(view.width) != _codecCtx->width ||
+			static_cast<int>(view.height) != _codecCtx->height)
+		{
+			// The conversion copies the image, thus the buffers can be
+			// returned immediately
+			const bool written = writeView(view, pts);
+			if (release)
+				release();
+			return written;
+		}
+
+		auto owner = new ExternalFrame;
+		owner->release = std::move(release);
+		owner->references = nr_planes;
+
+		AVFrame* frame = _framePool->getEmpty();
+		for (int p = 0; p < nr_planes; p++)
+		{
+			AVBufferRef* buf = nullptr;
+			if (frame)
+			{
+				const int size = static_cast<int>(view.planes[p].size());
+				buf = av_buffer_create(const_cast<uint8_t*>(view.planes[p].data()), size, releasePlane, owner, AV_BUFFER_FLAG_READONLY);
+			}
+			if (!buf)
+			{
+				// Account for the planes without buffer. The callback is
+				// invoked once the created buffers are freed.
+				for (int q = p; q < nr_planes; q++)
+					releasePlane(owner, nullptr);
+				_framePool->put(frame);
+				return false;
+			}
+
+			frame->buf[p] = buf;
+			frame->data[p] = buf->data;
+			frame->linesize[p] = view.strides[p];
+		}
+		frame->format = fmt;
+		frame->width = _codecCtx->width;
+		frame->height = _codecCtx->height;
+		frame->pts = pts;
+
+		// The frame is reference counted, thus neither the queue nor the
+		// encoder need to copy it
+		if (_async)
+		{
+			if (_pipelineFailed)
+			{
+				_framePool->put(frame);
+				return false;
+			}
+			return submit(frame);
+		}
+
+		const bool written = encode(frame);
+		_framePool->put(frame);
+		return written;
+	}
+
+	bool Recorder::writeConverted(const uint8_t* const src[4], const int src_stride[4], int fmt, int w, int h, int64_t pts)
+	{
+		// In asynchronous mode the image is converted into a pooled frame which
+		// is directly queued. Otherwise, the processing frame is reused unless
+		// the encoder still references it.
+		AVFrame* frame = _processing_frame;
+		if (_async)
+		{
+			if (_pipelineFailed)
+				return false;
+
+			frame = _framePool->get();
+			if (!frame)
+				return false;
+		}
+		else if (!av_frame_is_writable(frame))
+		{
+			frame = _framePool->get();
+			if (!frame)
+				return false;
+
+			_framePool->put(_processing_frame);
+			_processing_frame = frame;
+		}
+
+		// Convert into the input format of the encoder
+		bool converted = false;
+		{
+			ScopedStageTimer timer{ stageTimer(Stage::Convert) };
+			converted = _converter->convert(src, src_stride, static_cast<AVPixelFormat>(fmt), w, h, frame);
+		}
+		if (!converted)
+		{
+			if (_async)
+				_framePool->put(frame);
+			return false;
+		}
+		frame->pts = pts;
+
+		if (_async)
+			return submit(frame);
+		else
+			return encode(frame);
+	}
+
+	bool Recorder::write(AVFrame* frame)
+	{
+		// Convert frames not matching the format negotiated with the encoder
+		if (frame && frame->format != _codecCtx->pix_fmt)
+			return writeConverted(frame->data, frame->linesize, frame->format, frame->width, frame->height, frame->pts);
+
+		if (_async)
+			return enqueue(frame);
+		else
+			return encode(frame);
+	}
+
+	bool Recorder::encode(AVFrame* frame)
+	{
+		// Send the frame to the codec for encoding
+		int av_err = -1;
+		{
+			ScopedStageTimer timer{ stageTimer(Stage::SendFrame) };
+			av_err = avcodec_send_frame(_codecCtx, frame);
+		}
+		if (av_err < 0)
+			return false;
+
+		for(;;)
+		{
+			// Query the codec for packets to be further processed and
+			// written to the output. The packet is reused for all frames.
+			{
+				ScopedStageTimer timer{ stageTimer(Stage::ReceivePacket) };
+				av_err = avcodec_receive_packet(_codecCtx, _packet);
+			}
+
+			// Check if there is actually something to write:
+			// EAGAIN: No image ready to be processed
+			// EOF: The image queue is empty
+			if (av_err == AVERROR(EAGAIN) || av_err == AVERROR_EOF)
+				return true;
+			else if (av_err < 0)
+				return false;
+
+			if (_packetQueue)
+			{
+				// Hand the packet data over to the muxer thread
+				AVPacket* queued_pkt = _packetPool->get();
+				if (!queued_pkt)
+				{
+					av_packet_unref(_packet);
+					return false;
+				}
+				av_packet_move_ref(queued_pkt, _packet);
+
+				// Frames no other frame depends on can be dropped instead of waiting for the muxer
+				if (_overflowPolicy == OverflowPolicy::DropNonReference && (queued_pkt->flags & AV_PKT_FLAG_DISPOSABLE))
+				{
+					if (!_packetQueue->tryPush(queued_pkt))
+					{
+						_packetPool->put(queued_pkt);
+						_overflowPackets.fetch_add(1, std::memory_order_relaxed);
+					}
+				}
+				else if (!_packetQueue->push(queued_pkt))
+				{
+					_packetPool->put(queued_pkt);
+					return false;
+				}
+			}
+			else if (!writePacket(_packet))
+			{
+				return false;
+			}
+		}
+		
+		return true;
+	}
+
+	bool Recorder::writePacket(AVPacket* pkt)
+	{
+		// Write the packet to the output
+		const int size = pkt->size;
+		bool written = false;
+		{
+			ScopedStageTimer timer{ stageTimer(Stage::WritePacket) };
+
+			// Additional outputs receive the timestamps of the encoder
+			if (!_replay)
+				writeOutputs(pkt);
+
+			if (_replay)
+			{
+				// Keep the packet in memory instead of writing it
+				written = _replay->push(pkt);
+			}
+			else if (_segmented)
+			{
+				try
+				{
+					// Decoders can only start at a keyframe, thus only those start a new segment
+					if (!_segmentEmpty && (pkt->flags & AV_PKT_FLAG_KEY) && isSegmentComplete(pkt->dts))
+						nextSegment();
+
+					if (_segmentEmpty)
+					{
+						if (_segmentIndex == _segments.start_index)
+							_firstDts = pkt->dts;
+						_segmentDts = pkt->dts;
+						_segmentEmpty = false;
+					}
+				}
+				catch (const std::exception&)
+				{
+					av_packet_unref(pkt);
+					return false;
+				}
+
+				// Every segment starts at the timestamps of the first one
+				const int64_t offset = _segmentDts - _firstDts;
+				pkt->pts -= offset;
+				pkt->dts -= offset;
+				written = _muxer->isOpen() && _muxer->write(pkt, _codecCtx->time_base);
+			}
+			else
+			{
+				written = _muxer->write(pkt, _codecCtx->time_base);
+			}
+		}
+		if (!written)
+			return false;
+
+		_packetsWritten.fetch_add(1, std::memory_order_relaxed);
+		_bytesWritten.fetch_add(static_cast<uint64_t>(size), std::memory_order_relaxed);
+		return true;
+	}
+
+	std::string Recorder::segmentPath(unsigned int index) const
+	{
+		std::array<char, 1024> path;
+		if (av_get_frame_filename2(path.data(), static_cast<int>(path.size()), _segments.pattern.c_str(), static_cast<int>(index), 0) < 0)
+			throw std::runtime_error("Creating segment name failed");
+
+		return path.data();
+	}
+
+	Mp4Options Recorder::segmentMp4Options() const
+	{
+		// Moving the index would rewrite every segment when it is finalized
+		Mp4Options mp4 = _mp4Options;
+		if (mp4.layout == Mp4Layout::Faststart)
+			mp4.layout = Mp4Layout::Default;
+
+		return mp4;
+	}
+
+	bool Recorder::isSegmentComplete(int64_t dts) const
+	{
+		if (_segments.duration.count() > 0)
+		{
+			const int64_t duration = av_rescale_q(_segments.duration.count(), { 1, 1000 }, _codecCtx->time_base);
+			if (dts - _segmentDts >= duration)
+				return true;
+		}
+		if (_segments.max_bytes > 0)
+		{
+			if (static_cast<uint64_t>(_muxer->bytesWritten()) >= _segments.max_bytes)
+				return true;
+		}
+
+		return false;
+	}
+
+	void Recorder::nextSegment()
+	{
+		if (!finalizeSegment())
+			throw std::runtime_error("Closing segment failed");
+
+		_segmentIndex++;
+		_segmentEmpty = true;
+		openFile(*_muxer, segmentPath(_segmentIndex), segmentMp4Options());
+	}
+
+	bool Recorder::finalizeSegment()
+	{
+		// Only complete segments are reported
+		if (!_muxer->close())
+			return false;
+
+		if (_segments.on_finalized)
+			_segments.on_finalized(segmentPath(_segmentIndex), _segmentIndex);
+		return true;
+	}
+
+	bool Recorder::enqueue(const AVFrame* frame)
+	{
+		// Report errors of the pipeline threads to the producer
+		if (_pipelineFailed)
+			return false;
+
+		// The input frame references memory owned by the caller, thus
+		// it has to be copied before 'write' returns.
+		AVFrame* queued_frame = _framePool->get();
+		if (!queued_frame)
+			return false;
+
+		if (av_frame_copy(queued_frame, frame) < 0 ||
+			av_frame_copy_props(queued_frame, frame) < 0)
+		{
+			_framePool->put(queued_frame);
+			return false;
+		}
+
+		return submit(queued_frame);
+	}
+
+	bool Recorder::submit(AVFrame* frame)
+	{
+		switch (_overflowPolicy)
+		{
+		case OverflowPolicy::DropNewest:
+		case OverflowPolicy::DropNonReference:
+		{
+			if (_frameQueue->tryPush(frame))
+			{
+				scheduleEncode();
+				return true;
+			}
+
+			// Distinguish a full from a closed queue
+			_framePool->put(frame);
+			if (_pipelineFailed)
+				return false;
+
+			_overflowFrames.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+		case OverflowPolicy::DropOldest:
+		{
+			AVFrame* evicted = nullptr;
+			bool was_evicted = false;
+			if (!_frameQueue->pushEvict(frame, evicted, was_evicted))
+				break;
+
+			// The task scheduled for the evicted frame encodes the new one
+			if (was_evicted)
+			{
+				_framePool->put(evicted);
+				_overflowFrames.fetch_add(1, std::memory_order_relaxed);
+			}
+			else
+			{
+				scheduleEncode();
+			}
+			return true;
+		}
+		default:
+			if (_frameQueue->push(frame))
+			{
+				scheduleEncode();
+				return true;
+			}
+			break;
+		}
+
+		_framePool->put(frame);
+		return false;
+	}
+
+	void Recorder::scheduleEncode()
+	{
+		if (!_strand)
+			return;
+
+		// Each task encodes a single frame, such that the recorders sharing
+		// the scheduler are served in turn
+		_strand->post([this]()
+		{
+			AVFrame* frame = nullptr;
+			if (!_frameQueue->tryPop(frame))
+				return;
+
+			if (!encode(frame))
+				_pipelineFailed = true;
+			_framePool->put(frame);
+		});
+	}
+
+	void Recorder::encoderLoop()
+	{
+		AVFrame* frame = nullptr;
+		while (_frameQueue->pop(frame))
+		{
+			if (!encode(frame))
+				_pipelineFailed = true;
+			_framePool->put(frame);
+		}
+
+		// Flush the frames buffered in the codec
+		if (!encode(nullptr))
+			_pipelineFailed = true;
+
+		_packetQueue->close();
+	}
+
+	void Recorder::muxerLoop()
+	{
+		AVPacket* pkt = nullptr;
+		while (_packetQueue->pop(pkt))
+		{
+			if (!writePacket(pkt))
+				_pipelineFailed = true;
+			_packetPool->put(pkt);
 		}
-		
-		return true;
 	}
 }}}
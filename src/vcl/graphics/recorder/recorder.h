@@ -27,16 +27,29 @@
 
 // C++ standard library
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <thread>
 #include <utility>
+#include <vector>
 
 // GSL
 #include <gsl/gsl>
 
-#ifdef VCL_GRAPHICS_RECORDER_EXPORTS
-#	define VCL_GRAPHICS_RECORDER_API __declspec(dllexport)   
-#else  
-#	define VCL_GRAPHICS_RECORDER_API __declspec(dllimport)   
-#endif 
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/boundedqueue.h>
+#include <vcl/graphics/recorder/encodersettings.h>
+#include <vcl/graphics/recorder/filewriter.h>
+#include <vcl/graphics/recorder/frameview.h>
+#include <vcl/graphics/recorder/mp4options.h>
+#include <vcl/graphics/recorder/pixelformat.h>
+#include <vcl/graphics/recorder/replaybuffer.h>
+#include <vcl/graphics/recorder/segmentoptions.h>
+#include <vcl/graphics/recorder/stats.h>
 
 extern "C"
 {
@@ -45,11 +58,21 @@ extern "C"
 	struct AVCodecParameters;
 	struct AVFormatContext;
 	struct AVFrame;
+	struct AVPacket;
 	struct AVStream;
 }
 
 namespace Vcl { namespace Graphics { namespace Recorder
 {
+	class FrameConverter;
+	class FramePool;
+	class Muxer;
+	class OutputSink;
+	class PacketPool;
+	class Scheduler;
+	class StaticFrameDetector;
+	class Strand;
+
 	enum class OutputFormat
 	{
 		Avi,
@@ -57,38 +80,436 @@ namespace Vcl { namespace Graphics { namespace Recorder
 		Mp4
 	};
 
+	//! Video codecs. Not every container supports every codec,
+	//! the combination is validated when creating the recorder.
 	enum class CodecType
 	{
-		H264
+		//! H.264 / AVC
+		H264,
+
+		//! H.265 / HEVC
+		Hevc,
+
+		//! VP9
+		Vp9,
+
+		//! AV1
+		Av1,
+
+		//! FFV1, lossless intra-only
+		Ffv1
+	};
+
+	//! Parallelization strategy of the encoder
+	enum class ThreadingModel
+	{
+		//! Let the encoder decide
+		Auto,
+
+		//! Encode multiple frames concurrently. Higher throughput, adds
+		//! a delay of one frame per thread.
+		Frame,
+
+		//! Split each frame into slices encoded concurrently. No
+		//! additional delay, slightly lower compression efficiency.
+		Slice
+	};
+
+	//! Timing of the encoded images
+	enum class FrameTiming
+	{
+		//! Every image lasts one frame interval. Images with explicit
+		//! timestamps are repeated or dropped to fill every interval once.
+		Constant,
+
+		//! Images are stored with the timestamps of the caller. Requires
+		//! a container supporting variable frame rates (MKV, MP4).
+		Variable
+	};
+
+	//! Handling of images written while the queue of the asynchronous pipeline is full
+	enum class OverflowPolicy
+	{
+		//! 'write' waits until the encoder accepts the image
+		Block,
+
+		//! The image passed to 'write' is dropped
+		DropNewest,
+
+		//! The oldest queued image is dropped to make room
+		DropOldest,
+
+		//! Drop data no other frame depends on. Images are not referenced
+		//! before encoding, thus the image passed to 'write' is dropped.
+		//! Additionally, encoded packets marked as disposable (non-reference
+		//! B-frames) are dropped instead of waiting for the muxer.
+		DropNonReference
+	};
+
+	//! Time base of timestamps, given as fraction of a second
+	struct TimeBase
+	{
+		int num{0};
+		int den{1};
+	};
+
+	//! Threading configuration of the encoder
+	struct EncoderThreads
+	{
+		//! Parallelization strategy
+		ThreadingModel model{ThreadingModel::Auto};
+
+		//! Number of encoder threads. 0 lets the encoder decide.
+		unsigned int count{0};
+
+		//! CPUs the encoding threads are restricted to. Empty for no restriction.
+		//! \note Applies to the pipeline threads of the recorder on all platforms.
+		//!       Threads spawned by the encoder are only restricted on Linux.
+		std::vector<unsigned int> affinity;
 	};
 
 	class VCL_GRAPHICS_RECORDER_API Recorder
 	{
 	public:
 		Recorder(OutputFormat out_fmt, CodecType codec);
+
+		//! Create a recorder using a specific encoder
+		//! \param out_fmt Container format
+		//! \param codec Codec used to compress the video
+		//! \param encoder Name of the FFmpeg encoder implementing 'codec'.
+		//!                An empty name selects the preferred encoder which can be opened.
+		Recorder(OutputFormat out_fmt, CodecType codec, absl::string_view encoder);
+
+		//! Create a recorder with specific encoder settings
+		//! \param out_fmt Container format
+		//! \param codec Codec used to compress the video
+		//! \param settings Profile and explicit overrides of the encoder parameters
+		Recorder(OutputFormat out_fmt, CodecType codec, EncoderSettings settings);
 		~Recorder();
 
+		//! Names of the encoders available for a codec
+		//! Only encoders which could be opened on this machine are listed.
+		//! \param codec Codec to query
+		//! \returns the encoders in the order of preference
+		//! \see EncoderRegistry
+		static std::vector<std::string> availableEncoders(CodecType codec);
+
+		//! Name of the encoder in use
+		const char* encoderName() const;
+
 	public:
+		//! Enable the asynchronous encoding pipeline
+		//! In asynchronous mode 'write' only copies the frame into a queue.
+		//! Encoding and muxing are executed on dedicated threads, or by the
+		//! workers of a shared scheduler (see 'setScheduler').
+		//! \param enable Enable or disable the asynchronous mode
+		//! \param queue_size Number of frames queued before the overflow policy applies
+		//! \note Needs to be configured before calling 'open'
+		void setAsyncEncoding(bool enable, unsigned int queue_size = 8);
+
+		//! \returns true if the asynchronous encoding pipeline is used
+		bool isAsyncEncoding() const { return _async; }
+
+		//! Select how images are handled when the pipeline falls behind
+		//! Only applies to the asynchronous mode, in synchronous mode 'write'
+		//! always encodes the image.
+		//! \note Needs to be configured before calling 'open'
+		void setOverflowPolicy(OverflowPolicy policy);
+		OverflowPolicy overflowPolicy() const { return _overflowPolicy; }
+
+		//! Execute the asynchronous pipeline on a shared scheduler
+		//! Instead of dedicated threads, the queued frames of the recorder
+		//! are encoded and written by the workers of the scheduler, in turn
+		//! with the other recorders using it. Unless set explicitly, the
+		//! encoder then uses a single thread.
+		//! \param scheduler Scheduler to use, e.g. 'Scheduler::global()'.
+		//!                  nullptr to use dedicated threads.
+		//! \note Only applies to the asynchronous mode
+		//! \note Needs to be configured before calling 'open'
+		void setScheduler(std::shared_ptr<Scheduler> scheduler);
+		const std::shared_ptr<Scheduler>& scheduler() const { return _scheduler; }
+
+		//! Check if an image can be written without waiting or being dropped
+		//! Allows the producer to skip capturing images the recorder cannot take.
+		//! \returns false if the queue of the asynchronous pipeline is full or the pipeline failed
+		bool canAccept() const;
+
+		//! Write files on a dedicated thread through a large buffer
+		//! A slow disk then only stalls the muxer once the buffer is full.
+		//! The stalls are reported in the writer statistics.
+		//! \param enable Enable or disable the writer thread
+		//! \param options Buffer size, preallocation and synchronization of the files
+		//! \note The data is not re-read, thus MP4 files are written without
+		//!       moving the index to the front. Use fragmented MP4 instead.
+		//! \note Needs to be configured before calling 'open'
+		void setBufferedWriter(bool enable, FileWriterOptions options = {});
+
+		//! \returns true if files are written by the writer thread
+		bool isBufferedWriter() const { return _bufferedWriter; }
+
+		//! Skip encoding images identical to the previous image
+		//! The following image then covers the time of the skipped images,
+		//! resulting in a variable frame rate. Each image is compared against
+		//! a copy of the previous one, changed images are copied.
+		//! \param enable Enable or disable the detection
+		//! \param max_skipped Maximum number of consecutive images skipped, 0 for no limit.
+		//!                    Limits the time between two packets, e.g. for segmented output.
+		//! \note Needs to be configured before calling 'open'
+		void setStaticFrameDetection(bool enable, unsigned int max_skipped = 0);
+
+		//! \returns true if unchanged images are skipped
+		bool isStaticFrameDetection() const { return _staticFrameDetector != nullptr; }
+
+		//! Select how timestamps are stored
+		//! Images written without timestamp are placed one frame interval
+		//! after the previous image in both modes.
+		//! \note Needs to be configured before calling 'open'
+		void setFrameTiming(FrameTiming timing);
+		FrameTiming frameTiming() const { return _frameTiming; }
+
+		//! Select the colour matrix used to convert RGB input
+		//! The matrix is also signaled in the output stream.
+		//! \note Needs to be configured before calling 'open'
+		void setColorMatrix(ColorMatrix matrix);
+		ColorMatrix colorMatrix() const { return _colorMatrix; }
+
+		//! Set the number of horizontal slices converted in parallel
+		//! when converting RGB input. The output does not depend on the
+		//! number of slices.
+		//! \param slices Number of slices. 0 selects the number of hardware threads.
+		void setConversionSlices(unsigned int slices);
+		unsigned int conversionSlices() const;
+
+		//! Configure the threading of the encoder
+		//! \note Needs to be configured before calling 'open'
+		void setEncoderThreads(EncoderThreads threads);
+
+		//! Threading configuration in effect
+		//! After 'open' the values reported by the encoder are returned.
+		//! A thread count of 0 indicates that the encoder chose the number
+		//! of threads internally.
+		EncoderThreads encoderThreads() const;
+
+		//! Configure the trade-off between encoding speed and compression
+		//! \note Needs to be configured before calling 'open'
+		void setEncoderSettings(EncoderSettings settings);
+		const EncoderSettings& encoderSettings() const { return _encoderSettings; }
+
+		//! Configure the layout of MP4 output
+		//! Defaults to 'Faststart'. Segments and sinks are written without
+		//! moving the index.
+		//! \note Needs to be configured before calling 'open'
+		void setMp4Options(Mp4Options options);
+		const Mp4Options& mp4Options() const { return _mp4Options; }
+
+		//! Add a container receiving the same encoded packets as the main output
+		//! The video is encoded once and each packet is shared by all outputs.
+		//! A failing additional output is closed without affecting the others.
+		//! \param fmt Container format of the additional output
+		//! \param url Path of the file to create when opening the recorder
+		//! \returns the index of the output
+		//! \throws std::domain_error if the container cannot store the codec
+		//! \note Needs to be configured before calling 'open'. Not supported in replay mode.
+		size_t addOutput(OutputFormat fmt, absl::string_view url);
+
+		//! Add a container writing into a sink
+		//! \param fmt Container format of the additional output
+		//! \param sink Destination of the data
+		//! \returns the index of the output
+		//! \throws std::domain_error if the container cannot store the codec or the sink is invalid
+		//! \note Needs to be configured before calling 'open'. Not supported in replay mode.
+		size_t addOutput(OutputFormat fmt, std::shared_ptr<OutputSink> sink);
+
+		//! Remove all additional outputs
+		//! \note Needs to be configured before calling 'open'
+		void clearOutputs();
+
+		//! \returns the number of additional outputs
+		size_t outputCount() const { return _outputs.size(); }
+
+		//! \returns true if opening or writing the additional output failed
+		//!          during the current or last recording
+		bool isOutputFailed(size_t index) const;
+
+		//! Enable measuring the time spent in the individual processing stages
+		//! When disabled, no timing information is collected. Packet and
+		//! byte counters are always maintained.
+		void setStatsEnabled(bool enable);
+		bool isStatsEnabled() const { return _statsEnabled.load(std::memory_order_relaxed); }
+
+		//! Snapshot of the collected statistics
+		//! Can be called concurrently to 'write'.
+		RecorderStats stats() const;
+
+		//! Clear the collected statistics
+		//! \note Must not be called concurrently to 'write'
+		void resetStats();
+
 		void open(absl::string_view sink_name, unsigned int width, unsigned int height, unsigned int frame_rate);
-		void close();
+
+		//! Open the output writing the container data to a sink
+		//! \param sink Destination of the data. Kept alive until 'close'.
+		//! \param width Width of the video
+		//! \param height Height of the video
+		//! \param frame_rate Frames per second
+		void open(std::shared_ptr<OutputSink> sink, unsigned int width, unsigned int height, unsigned int frame_rate);
+
+		//! Open the output splitting the recording into multiple files
+		//! \param segments File names and limits of the segments
+		//! \param width Width of the video
+		//! \param height Height of the video
+		//! \param frame_rate Frames per second
+		//! \throws std::domain_error if the pattern does not contain exactly one index placeholder
+		void open(const SegmentOptions& segments, unsigned int width, unsigned int height, unsigned int frame_rate);
+
+		//! Open the recorder keeping the most recent packets in memory
+		//! No output is written until 'dumpReplay' is called.
+		//! \param replay Amount of video to keep
+		//! \param width Width of the video
+		//! \param height Height of the video
+		//! \param frame_rate Frames per second
+		//! \throws std::domain_error if no byte budget is set
+		void open(const ReplayOptions& replay, unsigned int width, unsigned int height, unsigned int frame_rate);
+
+		//! Write the packets kept by the replay mode into a file
+		//! The packets are written without re-encoding them. Can be called
+		//! while recording and after 'close' until the recorder is re-opened.
+		//! \param path Name of the file to create
+		//! \param fmt Container of the file
+		//! \returns the number of packets written
+		//! \throws std::domain_error if the container cannot store the codec
+		//! \throws std::runtime_error if the recorder was not opened in replay mode
+		//!         or writing the file failed
+		size_t dumpReplay(absl::string_view path, OutputFormat fmt) const;
+
+		//! Copy the packets kept by the replay mode
+		//! Can be called while recording and after 'close' until the recorder is re-opened.
+		//! \param packets Receives new references to the packets in decoding order,
+		//!                which need to be freed by the caller
+		//! \throws std::runtime_error if the recorder was not opened in replay mode
+		void replayPackets(std::vector<AVPacket*>& packets) const;
+
+		//! Parameters of the encoded video stream, as stored in a container
+		//! \param par Receives the parameters of the opened encoder
+		//! \throws std::runtime_error if the parameters could not be copied
+		void streamParameters(AVCodecParameters* par) const;
+
+		//! Time base of the timestamps of the encoded packets
+		TimeBase timeBase() const;
+
+		//! Close the output. In asynchronous mode all queued frames are
+		//! encoded and written before returning.
+		//! \returns false if the trailer or buffered data of the output could
+		//!          not be written. Failing additional outputs are only counted.
+		bool close();
 
 		bool write(gsl::span<const uint8_t> Y, gsl::span<const uint8_t> U, gsl::span<const uint8_t> V);
 		bool write(gsl::span<const uint8_t> Y, gsl::span<const std::array<uint8_t, 2>> UV);
 		bool write(gsl::span<const std::array<uint8_t, 3>> rgb, unsigned int w, unsigned int h);
+		bool write(gsl::span<const std::array<uint8_t, 4>> bgra, unsigned int w, unsigned int h);
 
-	private:
-		//! Create the output format
-		//! \param fmt Format to create
-		//! \param ctx Context to assign the output format to
-		void createOutputFormat(OutputFormat fmt, gsl::not_null<AVFormatContext*> ctx) const;
+		//! Write a packed RGB image
+		//! \param pixels Tightly packed image data
+		//! \param fmt Layout of the image. Needs to be Rgb24, Bgr24 or Bgra.
+		//! \param w Width of the image
+		//! \param h Height of the image
+		bool write(gsl::span<const uint8_t> pixels, PixelFormat fmt, unsigned int w, unsigned int h);
+
+		//! Write an image with arbitrary strides
+		//! Images matching the encoder input format and size are passed to
+		//! the encoder without copying. Other images are converted.
+		//! \param frame View onto the image in caller memory
+		//! \throws std::domain_error if the planes are smaller than described by the view
+		bool write(const FrameView& frame);
+
+		//! Write an image without copying, transferring ownership of the planes
+		//! The planes are referenced until the encoder does not need them
+		//! anymore, which can be several frames later with B-frames or in
+		//! asynchronous mode. The callback signals that the memory can be reused.
+		//! \param frame View onto the image. The memory must stay valid and
+		//!              unmodified until 'release' is called.
+		//! \param release Called exactly once when the planes are not referenced
+		//!                anymore, also if writing fails. Can be called from any
+		//!                thread, at the latest when 'close' returns.
+		//! \throws std::domain_error if the view is invalid. The callback is not called.
+		bool write(const FrameView& frame, std::function<void()> release);
+
+		//! Write an image captured at a specific time
+		//! The first image of a recording starts at time 0, all timestamps
+		//! are relative to the first one. Images not advancing the time are
+		//! dropped. With constant frame timing, all but the first image of a
+		//! frame interval are dropped, and the image is repeated for the
+		//! intervals skipped since the previous image.
+		//! \param frame View onto the image in caller memory
+		//! \param timestamp Capture time in microseconds
+		//! \returns false if writing failed. Dropping an image is not a failure.
+		//! \throws std::domain_error if the planes are smaller than described by the view
+		bool write(const FrameView& frame, std::chrono::microseconds timestamp);
+
+		//! Write an image captured at a specific time
+		//! \param frame View onto the image in caller memory
+		//! \param time Capture time
+		bool write(const FrameView& frame, std::chrono::steady_clock::time_point time);
+
+		//! Write an image captured at a specific time without copying
+		//! \param frame View onto the image. The memory must stay valid and
+		//!              unmodified until 'release' is called.
+		//! \param release Called exactly once when the planes are not referenced anymore
+		//! \param timestamp Capture time in microseconds
+		bool write(const FrameView& frame, std::function<void()> release, std::chrono::microseconds timestamp);
 
+	private:
 		//! Prepare codec
 		//! \param codec Codec to create
-		std::pair<AVCodec*, AVCodecContext*> createCodec(CodecType codec_cfg) const;
+		//! \param encoder Name of the encoder. Empty to select the first available.
+		std::pair<AVCodec*, AVCodecContext*> createCodec(CodecType codec_cfg, absl::string_view encoder) const;
+
+		//! Open a file as output of a muxer
+		void openFile(Muxer& muxer, absl::string_view path, const Mp4Options& mp4);
+
+		//! Open the additional outputs. Failing outputs are skipped.
+		void openOutputs();
+
+		//! Close the additional outputs
+		void closeOutputs();
+
+		//! Pass an encoded packet to the additional outputs
+		//! \param pkt Packet to share. Its data is referenced, not consumed.
+		void writeOutputs(const AVPacket* pkt);
+
+		//! \returns true if the codec needs to be configured for a container
+		template<typename Predicate>
+		bool anyOutputFormat(Predicate pred) const;
+
+		//! Configure and open the codec for the requested video
+		void openCodec(unsigned int width, unsigned int height, unsigned int frame_rate);
+
+		//! Prepare the frames and start the pipeline threads
+		void startPipeline();
+
+
+		//! Apply the encoder settings to the codec context
+		void configureEncoder();
 
 		//! Configure specific H264 parameters
 		void configureH264();
 
+		//! Configure specific HEVC parameters
+		void configureHevc();
+
+		//! Configure specific VP9 parameters
+		void configureVp9();
+
+		//! Configure specific AV1 parameters
+		void configureAv1();
+
+		//! Configure specific FFV1 parameters
+		void configureFfv1();
+
+		//! Set a private option of the encoder
+		//! \throws std::runtime_error if the option cannot be set
+		void setCodecOption(const char* name, const char* value, int search_flags = 0);
+
 		//! Write a single frame to the output
 		//! \param frame Frame to write out. Use 'nullptr' to flush the codec.
 		//! \note Notes about internal API used:
@@ -96,11 +517,156 @@ namespace Vcl { namespace Graphics { namespace Recorder
 		//! * https://www.ffmpeg.org/doxygen/3.4/group__lavc__encdec.html
 		bool write(AVFrame* frame);
 
-		//! Hold the formating of the IO container
-		AVFormatContext* _fmtCtx{nullptr};
+		//! Send a frame to the encoder and forward the produced packets
+		//! \param frame Frame to encode. Use 'nullptr' to flush the codec.
+		bool encode(AVFrame* frame);
 
-		//! Recording stream
-		AVStream* _videoStream{nullptr};
+		//! Write an encoded packet to the output container
+		bool writePacket(AVPacket* pkt);
+
+		//! Outcome of scheduling an image with an explicit timestamp
+		enum class Schedule
+		{
+			Write,
+			Drop,
+			Failed
+		};
+
+		//! Timestamp of the next image without explicit timestamp
+		int64_t nextPts() const;
+
+		//! Register the timestamp of the next image
+		void advanceTo(int64_t pts);
+
+		//! Compute the timestamp of an image with explicit timestamp
+		//! The previous image is repeated to fill the skipped frame intervals.
+		//! \param pts Receives the timestamp in the time base of the codec
+		Schedule scheduleTimestamp(std::chrono::microseconds timestamp, int64_t& pts);
+
+		//! Check if an image is skipped by the static frame detection
+		//! \param pts Timestamp the image would have been encoded with
+		bool skipUnchanged(const FrameView& view, int64_t pts);
+
+		//! Apply the limit of consecutively skipped images
+		//! \param unchanged The image is identical to the previous one
+		//! \param pts Timestamp the image would have been encoded with
+		bool skipFrame(bool unchanged, int64_t pts);
+
+		//! Repeat the previous image to fill a frame interval
+		bool repeatPrevious(int64_t pts);
+
+		//! Write an image with a timestamp and keep it for repetition
+		bool writeRetained(const FrameView& view, int64_t pts);
+
+		//! Write an image with a timestamp
+		bool writeView(const FrameView& view, int64_t pts);
+
+		//! Write an image without copying with a timestamp
+		bool writeView(const FrameView& view, std::function<void()> release, int64_t pts);
+
+		//! File name of a segment
+		std::string segmentPath(unsigned int index) const;
+
+		//! MP4 options of the segments
+		Mp4Options segmentMp4Options() const;
+
+		//! Check if the current segment reached one of its limits
+		//! \param dts Decoding timestamp of the next keyframe
+		bool isSegmentComplete(int64_t dts) const;
+
+		//! Finalize the current segment and start the next one
+		void nextSegment();
+
+		//! Finalize the current segment and notify the user
+		//! \returns false if closing the segment failed. The user is not notified.
+		bool finalizeSegment();
+
+		//! Copy a frame into the queue of the asynchronous pipeline
+		bool enqueue(const AVFrame* frame);
+
+		//! Pass an owned frame to the asynchronous pipeline
+		//! \param frame Frame to queue. The pipeline takes ownership.
+		bool submit(AVFrame* frame);
+
+		//! Convert an image into the encoder input format and write it
+		//! \param fmt FFmpeg pixel format of the source image
+		bool writeConverted(const uint8_t* const src[4], const int src_stride[4], int fmt, int w, int h, int64_t pts);
+
+		//! Signal the colour matrix in the codec parameters
+		void configureColorSpace();
+
+		//! Histogram of a stage if statistics are enabled, else 'nullptr'
+		LatencyHistogram* stageTimer(Stage stage)
+		{
+			return _statsEnabled.load(std::memory_order_relaxed) ? &_stageTimes[static_cast<size_t>(stage)] : nullptr;
+		}
+
+		//! Thread function encoding the queued frames
+		void encoderLoop();
+
+		//! Let the scheduler encode the next queued frame
+		void scheduleEncode();
+
+		//! Thread function writing the encoded packets
+		void muxerLoop();
+
+		//! Container format
+		OutputFormat _outputFormat{OutputFormat::Mkv};
+
+		//! Output container
+		std::unique_ptr<Muxer> _muxer;
+
+		//! Additional container receiving the encoded packets
+		struct TeeOutput
+		{
+			//! Container format
+			OutputFormat format;
+
+			//! Path of the file to create, if not writing to a sink
+			std::string url;
+
+			//! Sink receiving the output
+			std::shared_ptr<OutputSink> sink;
+
+			//! Writes the container
+			std::unique_ptr<Muxer> muxer;
+
+			//! Opening or writing the output failed
+			std::atomic<bool> failed{false};
+		};
+
+		//! Additional outputs sharing the encoded packets
+		std::vector<std::unique_ptr<TeeOutput>> _outputs;
+
+		//! Packet referencing the data written to an additional output
+		AVPacket* _teePacket{nullptr};
+
+		//! Number of additional outputs which failed
+		std::atomic<uint64_t> _failedOutputs{0};
+
+		//! Packets kept by the replay mode
+		std::unique_ptr<ReplayBuffer> _replay;
+
+		//! Split the output into multiple files
+		bool _segmented{false};
+
+		//! Configuration of the segments
+		SegmentOptions _segments;
+
+		//! Index of the segment currently written
+		unsigned int _segmentIndex{0};
+
+		//! Decoding timestamp of the first packet of the recording
+		int64_t _firstDts{0};
+
+		//! Decoding timestamp of the first packet of the current segment
+		int64_t _segmentDts{0};
+
+		//! The current segment did not receive a packet yet
+		bool _segmentEmpty{true};
+
+		//! Requested codec
+		CodecType _codecType{CodecType::H264};
 
 		//! Actual codec
 		AVCodec* _codec{nullptr};
@@ -114,7 +680,138 @@ namespace Vcl { namespace Graphics { namespace Recorder
 		//! Temporary frames for data processing
 		AVFrame* _processing_frame{nullptr};
 
-		//! Current frame count
+		//! Frame referencing the planes provided by the caller
+		AVFrame* _input_frame{nullptr};
+
+		//! Copy of the last image with explicit timestamp, repeated to
+		//! fill frame intervals without image
+		AVFrame* _previousFrame{nullptr};
+
+		//! Packet receiving the encoder output
+		AVPacket* _packet{nullptr};
+
+		//! Recycled frames of the codec input format
+		std::unique_ptr<FramePool> _framePool;
+
+		//! Recycled packets passed to the muxer thread
+		std::unique_ptr<PacketPool> _packetPool;
+
+		//! Allocations of the pools of previous recordings
+		//! Can wrap around temporarily after 'resetStats'.
+		uint64_t _poolAllocations{0};
+
+		//! Conversion of images not matching the codec input format
+		std::unique_ptr<FrameConverter> _converter;
+
+		//! Colour matrix of the YUV output
+		ColorMatrix _colorMatrix{ColorMatrix::Bt601};
+
+		//! Requested encoder threading
+		EncoderThreads _encoderThreads;
+
+		//! Requested encoder parameters
+		EncoderSettings _encoderSettings;
+
+		//! Requested MP4 layout
+		Mp4Options _mp4Options;
+
+		//! Detection of unchanged images. 'nullptr' if disabled.
+		std::unique_ptr<StaticFrameDetector> _staticFrameDetector;
+
+		//! Maximum number of consecutively skipped images
+		unsigned int _maxSkippedFrames{0};
+
+		//! Number of images skipped since the last encoded image
+		unsigned int _consecutiveSkips{0};
+
+		//! The last image was skipped
+		bool _lastSkipped{false};
+
+		//! Timestamp of the last skipped image
+		int64_t _lastSkippedPts{0};
+
+		//! Number of skipped images
+		std::atomic<uint64_t> _skippedFrames{0};
+
+		//! Write files on a dedicated thread
+		bool _bufferedWriter{false};
+
+		//! Configuration of the writer thread
+		FileWriterOptions _writerOptions;
+
+		//! Counters of the writer threads
+		std::shared_ptr<WriterCounters> _writerCounters;
+
+		//! Storage of the timestamps
+		FrameTiming _frameTiming{FrameTiming::Constant};
+
+		//! Number of images passed to the encoder, including skipped images
 		int64_t _frames{0};
+
+		//! Timestamp of the last image
+		int64_t _lastPts{0};
+
+		//! Duration of a frame interval in the time base of the codec
+		int64_t _frameDuration{1};
+
+		//! Caller timestamp of the first image
+		std::chrono::microseconds _timestampOrigin{0};
+
+		//! The origin of the timestamps was set
+		bool _hasTimestampOrigin{false};
+
+		//! Number of images dropped due to their timestamps
+		std::atomic<uint64_t> _droppedFrames{0};
+
+		//! Number of images repeated to fill frame intervals
+		std::atomic<uint64_t> _duplicatedFrames{0};
+
+		//! Use the asynchronous encoding pipeline
+		bool _async{false};
+
+		//! Number of frames the asynchronous pipeline can hold
+		unsigned int _queueSize{8};
+
+		//! Handling of images if the pipeline falls behind
+		OverflowPolicy _overflowPolicy{OverflowPolicy::Block};
+
+		//! Shared scheduler executing the pipeline instead of dedicated threads
+		std::shared_ptr<Scheduler> _scheduler;
+
+		//! Serializes the pipeline work of the recorder on the scheduler
+		std::shared_ptr<Strand> _strand;
+
+		//! Number of images dropped because the queue was full
+		std::atomic<uint64_t> _overflowFrames{0};
+
+		//! Number of packets dropped because the muxer was behind
+		std::atomic<uint64_t> _overflowPackets{0};
+
+		//! Frames waiting to be encoded
+		std::unique_ptr<BoundedQueue<AVFrame*>> _frameQueue;
+
+		//! Encoded packets waiting to be written
+		std::unique_ptr<BoundedQueue<AVPacket*>> _packetQueue;
+
+		//! Thread running the encoder
+		std::thread _encoderThread;
+
+		//! Thread running the muxer
+		std::thread _muxerThread;
+
+		//! Set by the pipeline threads when an error occured
+		std::atomic<bool> _pipelineFailed{false};
+
+		//! Collect the stage timings
+		std::atomic<bool> _statsEnabled{false};
+
+		//! Latencies of the processing stages
+		std::array<LatencyHistogram, StageCount> _stageTimes;
+
+		//! Number of packets written to the container
+		std::atomic<uint64_t> _packetsWritten{0};
+
+		//! Number of encoded bytes written to the container
+		std::atomic<uint64_t> _bytesWritten{0};
 	};
 }}}
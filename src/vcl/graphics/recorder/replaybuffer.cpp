@@ -0,0 +1,143 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "replaybuffer.h"
+
+// C++ standard library
+#include <algorithm>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	ReplayBuffer::ReplayBuffer(uint64_t max_bytes, int64_t duration)
+	: _maxBytes(max_bytes)
+	, _duration(duration)
+	{
+	}
+
+	ReplayBuffer::~ReplayBuffer()
+	{
+		clear();
+		for (auto& pkt : _free)
+			av_packet_free(&pkt);
+	}
+
+	bool ReplayBuffer::push(AVPacket* pkt)
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+
+		const bool key = (pkt->flags & AV_PKT_FLAG_KEY) != 0;
+		if (!key && _gops.empty())
+		{
+			av_packet_unref(pkt);
+			return true;
+		}
+
+		AVPacket* stored = nullptr;
+		if (!_free.empty())
+		{
+			stored = _free.back();
+			_free.pop_back();
+		}
+		else if (!(stored = av_packet_alloc()))
+		{
+			av_packet_unref(pkt);
+			return false;
+		}
+		av_packet_move_ref(stored, pkt);
+
+		_packets.push_back(stored);
+		if (key)
+			_gops.push_back(1);
+		else
+			_gops.back()++;
+		_bytes += static_cast<uint64_t>(stored->size);
+
+		evict();
+		return true;
+	}
+
+	void ReplayBuffer::snapshot(std::vector<AVPacket*>& packets) const
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+
+		packets.reserve(packets.size() + _packets.size());
+		for (const AVPacket* pkt : _packets)
+		{
+			if (AVPacket* ref = av_packet_clone(pkt))
+				packets.push_back(ref);
+		}
+	}
+
+	void ReplayBuffer::clear()
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		while (!_gops.empty())
+			popGop();
+	}
+
+	uint64_t ReplayBuffer::bytes() const
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		return _bytes;
+	}
+
+	size_t ReplayBuffer::size() const
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		return _packets.size();
+	}
+
+	void ReplayBuffer::evict()
+	{
+		// The newest GOP is always kept, even if it exceeds the budget
+		while (_gops.size() > 1)
+		{
+			// Without the oldest GOP the remaining ones still cover the requested duration
+			const AVPacket* second_gop = _packets[_gops.front()];
+			const AVPacket* newest = _packets.back();
+			const bool duration_exceeded = _duration > 0 && newest->dts - second_gop->dts >= _duration;
+			if (_bytes <= _maxBytes && !duration_exceeded)
+				break;
+
+			popGop();
+		}
+	}
+
+	void ReplayBuffer::popGop()
+	{
+		for (size_t i = _gops.front(); i > 0; i--)
+		{
+			AVPacket* pkt = _packets.front();
+			_packets.pop_front();
+			_bytes -= static_cast<uint64_t>(pkt->size);
+
+			av_packet_unref(pkt);
+			_free.push_back(pkt);
+		}
+		_gops.pop_front();
+	}
+}}}
@@ -0,0 +1,114 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+
+extern "C"
+{
+	struct AVPacket;
+}
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Configuration of the instant replay mode
+	struct ReplayOptions
+	{
+		//! Amount of video to keep. 0 keeps as much as the byte budget allows.
+		std::chrono::milliseconds duration{0};
+
+		//! Maximum size of the kept packets in bytes
+		uint64_t max_bytes{64 * 1024 * 1024};
+	};
+
+	//! Keeps the most recent encoded packets in memory
+	//! Packets are grouped by GOP, starting at a keyframe. Old GOPs are
+	//! evicted as a whole, thus the kept packets can always be decoded.
+	//! Packets can be added and read from different threads.
+	class VCL_GRAPHICS_RECORDER_API ReplayBuffer
+	{
+	public:
+		//! \param max_bytes Maximum size of the kept packets
+		//! \param duration Amount of video to keep in the time base of the packets.
+		//!                 0 keeps as much as 'max_bytes' allows.
+		ReplayBuffer(uint64_t max_bytes, int64_t duration);
+		ReplayBuffer(const ReplayBuffer&) = delete;
+		ReplayBuffer& operator=(const ReplayBuffer&) = delete;
+		~ReplayBuffer();
+
+		//! Add a packet, taking over its data
+		//! Packets preceding the first keyframe are discarded.
+		//! \returns false if the allocation failed
+		bool push(AVPacket* pkt);
+
+		//! Reference the kept packets
+		//! \param packets Receives new references to the kept packets, starting
+		//!                with the oldest keyframe. The caller has to free them.
+		void snapshot(std::vector<AVPacket*>& packets) const;
+
+		//! Remove all packets
+		void clear();
+
+		//! Size of the kept packets in bytes
+		uint64_t bytes() const;
+
+		//! Number of kept packets
+		size_t size() const;
+
+	private:
+		//! Remove the oldest GOPs exceeding the limits
+		void evict();
+
+		//! Remove the oldest GOP
+		void popGop();
+
+		//! Maximum size of the kept packets
+		uint64_t _maxBytes;
+
+		//! Amount of video to keep
+		int64_t _duration;
+
+		//! Kept packets, oldest first
+		std::deque<AVPacket*> _packets;
+
+		//! Number of packets of each kept GOP, oldest first
+		std::deque<size_t> _gops;
+
+		//! Size of the kept packets
+		uint64_t _bytes{0};
+
+		//! Packet objects of evicted packets available for reuse
+		std::vector<AVPacket*> _free;
+
+		//! Protects the packet lists
+		mutable std::mutex _mutex;
+	};
+}}}
@@ -0,0 +1,236 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "scheduler.h"
+
+// C++ standard library
+#include <algorithm>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Interval in which workers prefer the global queue over their own,
+		//! such that newly runnable strands are not starved by busy workers
+		const uint64_t GlobalQueueInterval = 4;
+
+		//! Worker executing on the current thread
+		thread_local const Scheduler* CurrentScheduler = nullptr;
+		thread_local unsigned int CurrentWorker = 0;
+	}
+
+	Strand::Strand(Scheduler& scheduler)
+	: _scheduler(scheduler)
+	{
+	}
+
+	void Strand::post(std::function<void()> task)
+	{
+		bool schedule = false;
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_tasks.emplace_back(std::move(task));
+			if (!_scheduled)
+			{
+				_scheduled = true;
+				schedule = true;
+			}
+		}
+
+		if (schedule)
+			_scheduler.schedule(shared_from_this());
+	}
+
+	void Strand::drain()
+	{
+		std::unique_lock<std::mutex> lock{ _mutex };
+		_idle.wait(lock, [this]() { return !_scheduled; });
+	}
+
+	bool Strand::run()
+	{
+		std::function<void()> task;
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			task = std::move(_tasks.front());
+			_tasks.pop_front();
+		}
+
+		task();
+		_scheduler._tasks.fetch_add(1, std::memory_order_relaxed);
+
+		std::lock_guard<std::mutex> lock{ _mutex };
+		if (!_tasks.empty())
+			return true;
+
+		_scheduled = false;
+		_idle.notify_all();
+		return false;
+	}
+
+	Scheduler::Scheduler(unsigned int threads)
+	{
+		if (threads == 0)
+			threads = std::max(1u, std::thread::hardware_concurrency());
+
+		// Create all queues before any worker starts stealing
+		_workers.reserve(threads);
+		for (unsigned int i = 0; i < threads; i++)
+			_workers.emplace_back(std::make_unique<Worker>());
+		for (unsigned int i = 0; i < threads; i++)
+			_workers[i]->thread = std::thread{ [this, i]() { run(i); } };
+	}
+
+	Scheduler::~Scheduler()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_shutdown = true;
+		}
+		_wake.notify_all();
+
+		for (auto& worker : _workers)
+			worker->thread.join();
+	}
+
+	std::shared_ptr<Scheduler> Scheduler::global()
+	{
+		static std::shared_ptr<Scheduler> scheduler = std::make_shared<Scheduler>();
+		return scheduler;
+	}
+
+	std::shared_ptr<Strand> Scheduler::createStrand()
+	{
+		return std::shared_ptr<Strand>{ new Strand{ *this } };
+	}
+
+	SchedulerStats Scheduler::stats() const
+	{
+		SchedulerStats stats;
+		stats.workers = size();
+		stats.tasks = _tasks.load(std::memory_order_relaxed);
+		stats.steals = _steals.load(std::memory_order_relaxed);
+
+		return stats;
+	}
+
+	void Scheduler::schedule(std::shared_ptr<Strand> strand)
+	{
+		{
+			// Publish the work while holding the lock, such that no worker
+			// misses the notification between checking and going to sleep.
+			// The counter is raised before the strand can be taken.
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_pending++;
+
+			// Keep the strand local to the worker making it runnable
+			if (CurrentScheduler == this)
+			{
+				Worker& worker = *_workers[CurrentWorker];
+				std::lock_guard<std::mutex> worker_lock{ worker.mutex };
+				worker.strands.emplace_back(std::move(strand));
+			}
+			else
+			{
+				_global.emplace_back(std::move(strand));
+			}
+		}
+		_wake.notify_one();
+	}
+
+	void Scheduler::run(unsigned int index)
+	{
+		CurrentScheduler = this;
+		CurrentWorker = index;
+
+		uint64_t tick = 0;
+		for (;;)
+		{
+			std::shared_ptr<Strand> strand;
+			if (!next(index, tick, strand))
+			{
+				std::unique_lock<std::mutex> lock{ _mutex };
+				_wake.wait(lock, [this]() { return _shutdown || _pending > 0; });
+				if (_shutdown && _pending == 0)
+					break;
+				continue;
+			}
+			_pending--;
+			tick++;
+
+			// Queue the strand again after a single task, such that the
+			// other runnable strands get their turn
+			if (strand->run())
+				schedule(std::move(strand));
+		}
+
+		CurrentScheduler = nullptr;
+	}
+
+	bool Scheduler::next(unsigned int index, uint64_t tick, std::shared_ptr<Strand>& strand)
+	{
+		if (tick % GlobalQueueInterval == 0 && takeGlobal(strand))
+			return true;
+
+		{
+			Worker& own = *_workers[index];
+			std::lock_guard<std::mutex> lock{ own.mutex };
+			if (!own.strands.empty())
+			{
+				strand = std::move(own.strands.front());
+				own.strands.pop_front();
+				return true;
+			}
+		}
+
+		if (takeGlobal(strand))
+			return true;
+
+		// Steal the most recently queued strand of another worker
+		const unsigned int workers = size();
+		for (unsigned int i = 1; i < workers; i++)
+		{
+			Worker& victim = *_workers[(index + i) % workers];
+			std::lock_guard<std::mutex> lock{ victim.mutex };
+			if (!victim.strands.empty())
+			{
+				strand = std::move(victim.strands.back());
+				victim.strands.pop_back();
+				_steals.fetch_add(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool Scheduler::takeGlobal(std::shared_ptr<Strand>& strand)
+	{
+		std::lock_guard<std::mutex> lock{ _mutex };
+		if (_global.empty())
+			return false;
+
+		strand = std::move(_global.front());
+		_global.pop_front();
+		return true;
+	}
+}}}
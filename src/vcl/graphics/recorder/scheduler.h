@@ -0,0 +1,169 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/stats.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	class Scheduler;
+
+	//! Serial queue of tasks executed by a scheduler
+	//! The tasks of a strand are executed one after the other in the order
+	//! they were posted. Different strands are executed concurrently.
+	class VCL_GRAPHICS_RECORDER_API Strand : public std::enable_shared_from_this<Strand>
+	{
+		friend class Scheduler;
+
+	public:
+		Strand(const Strand&) = delete;
+		Strand& operator=(const Strand&) = delete;
+
+		//! Append a task
+		//! \param task Function to execute. Must not throw.
+		void post(std::function<void()> task);
+
+		//! Wait until all posted tasks are executed
+		//! \note Must not be called from a task of the same scheduler
+		void drain();
+
+	private:
+		explicit Strand(Scheduler& scheduler);
+
+		//! Execute the next tasks
+		//! \returns true if tasks remain
+		bool run();
+
+		//! Scheduler executing the tasks
+		Scheduler& _scheduler;
+
+		//! Protects the task queue
+		std::mutex _mutex;
+
+		//! Signals that all tasks are executed
+		std::condition_variable _idle;
+
+		//! Posted tasks
+		std::deque<std::function<void()>> _tasks;
+
+		//! Strand is queued or executed by a worker
+		bool _scheduled{false};
+	};
+
+	//! Fixed pool of worker threads shared by many recorders
+	//! Work is organized in strands. A runnable strand is queued at the worker
+	//! which made it runnable, or in a global queue if it was made runnable
+	//! by another thread. Idle workers steal strands from the other workers.
+	//! A strand only executes a single task before it is queued again, thus
+	//! all runnable strands are served in turn.
+	class VCL_GRAPHICS_RECORDER_API Scheduler
+	{
+		friend class Strand;
+
+	public:
+		//! Create the scheduler
+		//! \param threads Number of worker threads. 0 selects the number of hardware threads.
+		explicit Scheduler(unsigned int threads = 0);
+		Scheduler(const Scheduler&) = delete;
+		Scheduler& operator=(const Scheduler&) = delete;
+
+		//! Waits for all queued work before stopping the workers
+		~Scheduler();
+
+		//! Process-wide scheduler using one worker per hardware thread
+		static std::shared_ptr<Scheduler> global();
+
+		//! \returns the number of worker threads
+		unsigned int size() const { return static_cast<unsigned int>(_workers.size()); }
+
+		//! Create a new serial queue of tasks
+		std::shared_ptr<Strand> createStrand();
+
+		//! Snapshot of the activity of the workers
+		SchedulerStats stats() const;
+
+	private:
+		//! Queue of a worker thread
+		struct Worker
+		{
+			//! Runnable strands of the worker, executed in order
+			std::deque<std::shared_ptr<Strand>> strands;
+
+			//! Protects the queue
+			std::mutex mutex;
+
+			//! Thread executing the strands
+			std::thread thread;
+		};
+
+		//! Queue a runnable strand
+		void schedule(std::shared_ptr<Strand> strand);
+
+		//! Worker thread function
+		void run(unsigned int index);
+
+		//! Find the next strand to execute
+		//! \param index Worker searching for work
+		//! \param tick Number of strands the worker executed so far
+		bool next(unsigned int index, uint64_t tick, std::shared_ptr<Strand>& strand);
+
+		//! Take a strand from the global queue
+		bool takeGlobal(std::shared_ptr<Strand>& strand);
+
+		//! Worker threads and their queues
+		std::vector<std::unique_ptr<Worker>> _workers;
+
+		//! Strands made runnable outside of the workers
+		std::deque<std::shared_ptr<Strand>> _global;
+
+		//! Protects the global queue and the sleep state
+		std::mutex _mutex;
+
+		//! Wakes up idle workers
+		std::condition_variable _wake;
+
+		//! Number of queued strands. Incremented while holding '_mutex'.
+		std::atomic<size_t> _pending{0};
+
+		//! Stop the workers
+		bool _shutdown{false};
+
+		//! Number of executed tasks
+		std::atomic<uint64_t> _tasks{0};
+
+		//! Number of stolen strands
+		std::atomic<uint64_t> _steals{0};
+	};
+}}}
@@ -0,0 +1,60 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Split a recording into multiple files
+	//! A new file is started at the first keyframe after one of the limits
+	//! is reached. The encoder is not re-initialized between the files,
+	//! thus the configured GOP size determines how precisely the limits
+	//! are met.
+	struct SegmentOptions
+	{
+		//! Name of the files, containing a printf-style integer
+		//! placeholder for the segment index, e.g. "capture_%05d.mp4"
+		std::string pattern;
+
+		//! Index of the first segment
+		unsigned int start_index{0};
+
+		//! Duration of a segment. 0 disables the limit.
+		std::chrono::milliseconds duration{0};
+
+		//! Size of a segment in bytes. 0 disables the limit.
+		uint64_t max_bytes{0};
+
+		//! Called after a segment was completely written
+		//! The callback is invoked on the thread writing the packets,
+		//! which is the muxer thread in asynchronous mode.
+		//! \param path File name of the segment
+		//! \param index Index of the segment
+		std::function<void(const std::string& path, unsigned int index)> on_finalized;
+	};
+}}}
@@ -0,0 +1,214 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "sink.h"
+
+// C++ standard library
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#	include <io.h>
+#else
+#	include <unistd.h>
+#endif
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Compute the target of a seek operation
+		//! \returns the new position or -1 if it is invalid
+		int64_t seekTarget(int64_t position, int64_t size, int64_t offset, int whence)
+		{
+			int64_t target = -1;
+			switch (whence)
+			{
+			case SEEK_SET: target = offset; break;
+			case SEEK_CUR: target = position + offset; break;
+			case SEEK_END: target = size + offset; break;
+			default: return -1;
+			}
+
+			return target < 0 ? -1 : target;
+		}
+	}
+
+	bool NullSink::write(const uint8_t* /* data */, size_t size)
+	{
+		_position += static_cast<int64_t>(size);
+		_size = std::max(_size, _position);
+		_bytesWritten += static_cast<int64_t>(size);
+		return true;
+	}
+
+	int64_t NullSink::seek(int64_t offset, int whence)
+	{
+		const int64_t position = seekTarget(_position, _size, offset, whence);
+		if (position < 0)
+			return -1;
+
+		_position = position;
+		return _position;
+	}
+
+	MemorySink::MemorySink(size_t reserve)
+	{
+		_buffer.reserve(reserve);
+	}
+
+	bool MemorySink::write(const uint8_t* data, size_t size)
+	{
+		if (size == 0)
+			return true;
+
+		// Overwrite existing data and append the remainder
+		const size_t end = _position + size;
+		if (end > _buffer.size())
+			_buffer.resize(end);
+
+		std::memcpy(_buffer.data() + _position, data, size);
+		_position = end;
+		return true;
+	}
+
+	int64_t MemorySink::seek(int64_t offset, int whence)
+	{
+		const int64_t position = seekTarget(static_cast<int64_t>(_position), size(), offset, whence);
+		if (position < 0)
+			return -1;
+
+		// Seeking beyond the end fills the gap on the next write
+		_position = static_cast<size_t>(position);
+		return position;
+	}
+
+	std::vector<uint8_t> MemorySink::release()
+	{
+		_position = 0;
+		return std::move(_buffer);
+	}
+
+	CallbackSink::CallbackSink(WriteFunction write, SeekFunction seek)
+	: _write(std::move(write))
+	, _seek(std::move(seek))
+	{
+	}
+
+	bool CallbackSink::write(const uint8_t* data, size_t size)
+	{
+		if (!_write(data, size))
+			return false;
+
+		_position += static_cast<int64_t>(size);
+		_size = std::max(_size, _position);
+		return true;
+	}
+
+	int64_t CallbackSink::seek(int64_t offset, int whence)
+	{
+		if (!_seek)
+			return -1;
+
+		const int64_t position = seekTarget(_position, _size, offset, whence);
+		if (position < 0 || !_seek(position))
+			return -1;
+
+		_position = position;
+		return _position;
+	}
+
+	FileDescriptorSink::FileDescriptorSink(int fd, bool take_ownership)
+	: _fd(fd)
+	, _ownsFd(take_ownership)
+	{
+		// Pipes and sockets fail to report a position
+#ifdef _WIN32
+		_origin = _lseeki64(_fd, 0, SEEK_CUR);
+#else
+		_origin = lseek(_fd, 0, SEEK_CUR);
+#endif
+		_seekable = _origin >= 0;
+	}
+
+	FileDescriptorSink::~FileDescriptorSink()
+	{
+		if (_ownsFd)
+		{
+#ifdef _WIN32
+			_close(_fd);
+#else
+			::close(_fd);
+#endif
+		}
+	}
+
+	bool FileDescriptorSink::write(const uint8_t* data, size_t size)
+	{
+		// Pipes and sockets can accept less data than requested
+		size_t remaining = size;
+		while (remaining > 0)
+		{
+#ifdef _WIN32
+			const auto written = _write(_fd, data, static_cast<unsigned int>(std::min<size_t>(remaining, 1u << 30)));
+#else
+			const auto written = ::write(_fd, data, remaining);
+#endif
+			if (written < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				return false;
+			}
+
+			data += written;
+			remaining -= static_cast<size_t>(written);
+		}
+
+		_position += static_cast<int64_t>(size);
+		_size = std::max(_size, _position);
+		return true;
+	}
+
+	int64_t FileDescriptorSink::seek(int64_t offset, int whence)
+	{
+		if (!_seekable)
+			return -1;
+
+		const int64_t position = seekTarget(_position, _size, offset, whence);
+		if (position < 0)
+			return -1;
+
+#ifdef _WIN32
+		if (_lseeki64(_fd, _origin + position, SEEK_SET) < 0)
+#else
+		if (lseek(_fd, static_cast<off_t>(_origin + position), SEEK_SET) < 0)
+#endif
+			return -1;
+
+		_position = position;
+		return _position;
+	}
+}}}
@@ -0,0 +1,191 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Destination of the container data written by a recorder
+	//! Sinks allow to write the output to other targets than files.
+	//! \note Containers rewriting parts of the file on close (MP4 with
+	//!       'faststart') cannot re-read the data from a sink. MP4 output
+	//!       to a sink is written without moving the index to the front.
+	//!       Sinks which do not support seeking require fragmented MP4.
+	class VCL_GRAPHICS_RECORDER_API OutputSink
+	{
+	public:
+		virtual ~OutputSink() = default;
+
+		//! Write data at the current position
+		//! \returns false if the data could not be written
+		virtual bool write(const uint8_t* data, size_t size) = 0;
+
+		//! Change the current position
+		//! \param offset Position relative to the origin
+		//! \param whence Origin of the new position (SEEK_SET, SEEK_CUR, SEEK_END)
+		//! \returns the new position or -1 if the sink does not support seeking
+		virtual int64_t seek(int64_t offset, int whence) = 0;
+
+		//! \returns the total number of bytes in the sink or -1 if unknown
+		virtual int64_t size() const = 0;
+
+		//! \returns true if the sink supports seeking
+		virtual bool isSeekable() const = 0;
+
+		//! Called once the container is complete
+		//! \returns false if the data could not be stored completely
+		virtual bool close() { return true; }
+	};
+
+	//! Sink discarding all data
+	//! Used to measure encoding performance without the influence of I/O.
+	class VCL_GRAPHICS_RECORDER_API NullSink : public OutputSink
+	{
+	public:
+		bool write(const uint8_t* data, size_t size) override;
+		int64_t seek(int64_t offset, int whence) override;
+		int64_t size() const override { return _size; }
+		bool isSeekable() const override { return true; }
+
+		//! \returns the number of bytes passed to the sink
+		int64_t bytesWritten() const { return _bytesWritten; }
+
+	private:
+		//! Current write position
+		int64_t _position{0};
+
+		//! Size of the virtual file
+		int64_t _size{0};
+
+		//! Total number of bytes passed to 'write'
+		int64_t _bytesWritten{0};
+	};
+
+	//! Sink collecting the output in a growable memory buffer
+	//! \note The buffer must not be accessed while a recorder writes to the sink
+	class VCL_GRAPHICS_RECORDER_API MemorySink : public OutputSink
+	{
+	public:
+		//! \param reserve Number of bytes to allocate up-front
+		explicit MemorySink(size_t reserve = 0);
+
+		bool write(const uint8_t* data, size_t size) override;
+		int64_t seek(int64_t offset, int whence) override;
+		int64_t size() const override { return static_cast<int64_t>(_buffer.size()); }
+		bool isSeekable() const override { return true; }
+
+		//! Data written to the sink
+		const std::vector<uint8_t>& data() const { return _buffer; }
+
+		//! Move the data out of the sink, leaving it empty
+		std::vector<uint8_t> release();
+
+	private:
+		//! Written data
+		std::vector<uint8_t> _buffer;
+
+		//! Current write position
+		size_t _position{0};
+	};
+
+	//! Sink forwarding the output to user provided functions
+	class VCL_GRAPHICS_RECORDER_API CallbackSink : public OutputSink
+	{
+	public:
+		//! Write data at the current position. Returns false on failure.
+		using WriteFunction = std::function<bool(const uint8_t* data, size_t size)>;
+
+		//! Change the absolute write position. Returns false on failure.
+		using SeekFunction = std::function<bool(int64_t position)>;
+
+		//! \param write Called for every block of data
+		//! \param seek Called when the container rewrites earlier data.
+		//!             Empty if the destination only supports appending.
+		explicit CallbackSink(WriteFunction write, SeekFunction seek = {});
+
+		bool write(const uint8_t* data, size_t size) override;
+		int64_t seek(int64_t offset, int whence) override;
+		int64_t size() const override { return _size; }
+		bool isSeekable() const override { return static_cast<bool>(_seek); }
+
+	private:
+		//! User provided write function
+		WriteFunction _write;
+
+		//! User provided seek function
+		SeekFunction _seek;
+
+		//! Current write position
+		int64_t _position{0};
+
+		//! Size of the written data
+		int64_t _size{0};
+	};
+
+	//! Sink writing to an open file descriptor
+	//! Pipes and sockets do not support seeking, regular files do.
+	//! \note Writing to a pipe or socket without reader raises SIGPIPE
+	//!       unless the application ignores the signal.
+	class VCL_GRAPHICS_RECORDER_API FileDescriptorSink : public OutputSink
+	{
+	public:
+		//! \param fd Descriptor opened for writing
+		//! \param take_ownership Close the descriptor when the sink is destroyed
+		FileDescriptorSink(int fd, bool take_ownership);
+		FileDescriptorSink(const FileDescriptorSink&) = delete;
+		FileDescriptorSink& operator=(const FileDescriptorSink&) = delete;
+		~FileDescriptorSink() override;
+
+		bool write(const uint8_t* data, size_t size) override;
+		int64_t seek(int64_t offset, int whence) override;
+		int64_t size() const override { return _size; }
+		bool isSeekable() const override { return _seekable; }
+
+	private:
+		//! Destination of the data
+		int _fd;
+
+		//! Close the descriptor on destruction
+		bool _ownsFd;
+
+		//! The descriptor supports seeking
+		bool _seekable;
+
+		//! Current write position relative to the position at creation
+		int64_t _position{0};
+
+		//! Size of the written data
+		int64_t _size{0};
+
+		//! Position of the descriptor at creation
+		int64_t _origin{0};
+	};
+}}}
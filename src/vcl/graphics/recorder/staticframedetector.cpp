@@ -0,0 +1,96 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "staticframedetector.h"
+
+// C++ standard library
+#include <cstring>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	bool StaticFrameDetector::isUnchanged(const FrameView& view)
+	{
+		// Images of a different layout are always a change
+		if (!_valid || view.format != _format || view.width != _width || view.height != _height)
+		{
+			_format = view.format;
+			_width = view.width;
+			_height = view.height;
+			for (int p = 0; p < FrameView::MaxPlanes; p++)
+			{
+				const size_t size = p < FrameView::planeCount(view.format)
+					? static_cast<size_t>(FrameView::rowBytes(view.format, p, view.width)) * FrameView::rowCount(view.format, p, view.height)
+					: 0;
+				_planes[p].resize(size);
+			}
+			_valid = false;
+		}
+
+		bool unchanged = _valid;
+		for (int p = 0; p < FrameView::planeCount(view.format); p++)
+		{
+			const size_t row_bytes = static_cast<size_t>(FrameView::rowBytes(view.format, p, view.width));
+			const int rows = FrameView::rowCount(view.format, p, view.height);
+			const uint8_t* src = view.planes[p].data();
+			uint8_t* dst = _planes[p].data();
+
+			// Skip the identical rows. The C library provides vectorized comparisons.
+			int y = 0;
+			if (unchanged)
+			{
+				for (; y < rows; y++)
+				{
+					if (std::memcmp(src + static_cast<ptrdiff_t>(y) * view.strides[p], dst + y * row_bytes, row_bytes) != 0)
+						break;
+				}
+				unchanged = y == rows;
+			}
+
+			// Remember the remaining rows
+			for (; y < rows; y++)
+				std::memcpy(dst + y * row_bytes, src + static_cast<ptrdiff_t>(y) * view.strides[p], row_bytes);
+		}
+		_valid = true;
+
+		return unchanged;
+	}
+
+	void StaticFrameDetector::reset()
+	{
+		_valid = false;
+	}
+
+	FrameView StaticFrameDetector::previous() const
+	{
+		FrameView view;
+		view.format = _format;
+		view.width = _width;
+		view.height = _height;
+		for (int p = 0; p < FrameView::planeCount(_format); p++)
+		{
+			view.planes[p] = { _planes[p].data(), static_cast<std::ptrdiff_t>(_planes[p].size()) };
+			view.strides[p] = FrameView::rowBytes(_format, p, _width);
+		}
+
+		return view;
+	}
+}}}
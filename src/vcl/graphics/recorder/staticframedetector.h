@@ -0,0 +1,69 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+#include <vcl/graphics/recorder/frameview.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Detects images identical to their predecessor
+	//! The image is compared row by row against a copy of the previous
+	//! image. Unchanged images are only read, changed images are copied
+	//! starting at the first changed row. The comparison is exact.
+	class VCL_GRAPHICS_RECORDER_API StaticFrameDetector
+	{
+	public:
+		//! Compare an image against the previous one and remember it
+		//! \param view Image to check. Needs to be valid.
+		//! \returns true if the image is identical to the previous image
+		bool isUnchanged(const FrameView& view);
+
+		//! Forget the previous image
+		void reset();
+
+		//! \returns true if an image was remembered
+		bool hasPrevious() const { return _valid; }
+
+		//! View onto the copy of the previous image
+		FrameView previous() const;
+
+	private:
+		//! Layout of the previous image
+		PixelFormat _format{PixelFormat::Yuv420P};
+		unsigned int _width{0};
+		unsigned int _height{0};
+
+		//! Tightly packed planes of the previous image
+		std::array<std::vector<uint8_t>, FrameView::MaxPlanes> _planes;
+
+		//! A previous image is available
+		bool _valid{false};
+	};
+}}}
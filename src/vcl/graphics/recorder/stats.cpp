@@ -0,0 +1,118 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "stats.h"
+
+// C++ standard library
+#include <algorithm>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	LatencyHistogram::LatencyHistogram()
+	{
+		reset();
+	}
+
+	void LatencyHistogram::record(std::chrono::nanoseconds latency)
+	{
+		const uint64_t ns = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+
+		_buckets[bucketIndex(ns)].fetch_add(1, std::memory_order_relaxed);
+		_total.fetch_add(ns, std::memory_order_relaxed);
+		if (ns > _max.load(std::memory_order_relaxed))
+			_max.store(ns, std::memory_order_relaxed);
+
+		// Publish the count last, readers never see more samples than
+		// stored in the buckets
+		_count.fetch_add(1, std::memory_order_release);
+	}
+
+	void LatencyHistogram::reset()
+	{
+		for (auto& bucket : _buckets)
+			bucket.store(0, std::memory_order_relaxed);
+		_count.store(0, std::memory_order_relaxed);
+		_total.store(0, std::memory_order_relaxed);
+		_max.store(0, std::memory_order_relaxed);
+	}
+
+	StageStats LatencyHistogram::summary() const
+	{
+		StageStats stats;
+		stats.count = _count.load(std::memory_order_acquire);
+		stats.total = std::chrono::nanoseconds{ _total.load(std::memory_order_relaxed) };
+		stats.max = std::chrono::nanoseconds{ _max.load(std::memory_order_relaxed) };
+		if (stats.count == 0)
+			return stats;
+
+		// Ranks of the requested percentiles, rounded up
+		const uint64_t rank50 = (stats.count * 50 + 99) / 100;
+		const uint64_t rank99 = (stats.count * 99 + 99) / 100;
+
+		uint64_t seen = 0;
+		bool found50 = false;
+		for (size_t i = 0; i < BucketCount; i++)
+		{
+			seen += _buckets[i].load(std::memory_order_relaxed);
+			if (!found50 && seen >= rank50)
+			{
+				stats.p50 = std::chrono::nanoseconds{ bucketUpperBound(i) };
+				found50 = true;
+			}
+			if (seen >= rank99)
+			{
+				stats.p99 = std::chrono::nanoseconds{ bucketUpperBound(i) };
+				break;
+			}
+		}
+
+		// The bucket bounds can exceed the exact maximum
+		stats.p50 = std::min(stats.p50, stats.max);
+		stats.p99 = std::min(stats.p99, stats.max);
+
+		return stats;
+	}
+
+	size_t LatencyHistogram::bucketIndex(uint64_t ns)
+	{
+		if (ns < LinearLimit)
+			return static_cast<size_t>(ns);
+
+		int exponent = 0;
+		for (uint64_t v = ns; v > 1; v >>= 1)
+			exponent++;
+
+		const size_t sub = static_cast<size_t>(ns >> (exponent - SubBucketBits)) & ((1 << SubBucketBits) - 1);
+		const size_t index = LinearLimit + static_cast<size_t>(exponent - 4) * (1 << SubBucketBits) + sub;
+		return std::min(index, BucketCount - 1);
+	}
+
+	uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+	{
+		if (index < LinearLimit)
+			return index;
+
+		const uint64_t exponent = (index - LinearLimit) / (1 << SubBucketBits) + 4;
+		const uint64_t sub = (index - LinearLimit) % (1 << SubBucketBits);
+		return ((1ull << exponent) + ((sub + 1) << (exponent - SubBucketBits))) - 1;
+	}
+}}}
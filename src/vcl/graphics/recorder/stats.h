@@ -0,0 +1,234 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Processing stages of a frame
+	enum class Stage
+	{
+		//! Conversion of the input into the codec pixel format
+		Convert,
+
+		//! Passing a frame to the encoder ('avcodec_send_frame')
+		SendFrame,
+
+		//! Retrieving an encoded packet ('avcodec_receive_packet')
+		ReceivePacket,
+
+		//! Writing a packet to the container ('av_interleaved_write_frame')
+		WritePacket
+	};
+
+	//! Number of entries in 'Stage'
+	const size_t StageCount = 4;
+
+	//! Latency summary of a single stage
+	struct StageStats
+	{
+		//! Number of measured invocations
+		uint64_t count{0};
+
+		//! Accumulated time of all invocations
+		std::chrono::nanoseconds total{0};
+
+		//! Median latency
+		std::chrono::nanoseconds p50{0};
+
+		//! 99th percentile of the latency
+		std::chrono::nanoseconds p99{0};
+
+		//! Maximum latency
+		std::chrono::nanoseconds max{0};
+	};
+
+	//! Statistics of the writer thread
+	struct WriterStats
+	{
+		//! Number of bytes waiting to be written to the disk
+		uint64_t queue_depth{0};
+
+		//! Maximum number of bytes waiting to be written to the disk
+		uint64_t max_queue_depth{0};
+
+		//! Number of times the muxer waited for buffer space
+		uint64_t stalls{0};
+
+		//! Accumulated time the muxer waited for buffer space
+		std::chrono::nanoseconds stall_time{0};
+
+		//! Number of times the data was synchronized to the disk
+		uint64_t syncs{0};
+	};
+
+	//! Snapshot of the statistics of a recorder
+	struct RecorderStats
+	{
+		//! Timings per stage. Only collected while enabled.
+		std::array<StageStats, StageCount> stages;
+
+		//! Number of packets written to the container
+		uint64_t packets{0};
+
+		//! Number of encoded bytes written to the container
+		uint64_t bytes_written{0};
+
+		//! Number of frames, image buffers and packets allocated by the
+		//! recorder. Stops growing once a recording reached its steady state.
+		uint64_t allocations{0};
+
+		//! Number of images skipped by the static frame detection
+		uint64_t skipped_frames{0};
+
+		//! Number of images dropped because their timestamps did not advance
+		//! the time, or with constant frame timing did not start a new interval
+		uint64_t dropped_frames{0};
+
+		//! Number of images repeated to fill frame intervals without image
+		uint64_t duplicated_frames{0};
+
+		//! Number of images dropped because the queue of the asynchronous pipeline was full
+		uint64_t overflow_frames{0};
+
+		//! Number of disposable packets dropped because the muxer fell behind
+		uint64_t overflow_packets{0};
+
+		//! Number of additional outputs closed due to an error
+		uint64_t failed_outputs{0};
+
+		//! Statistics of the writer thread, if enabled
+		WriterStats writer;
+
+		const StageStats& stage(Stage s) const { return stages[static_cast<size_t>(s)]; }
+	};
+
+	//! Activity of a shared scheduler
+	struct SchedulerStats
+	{
+		//! Number of worker threads
+		unsigned int workers{0};
+
+		//! Number of executed tasks
+		uint64_t tasks{0};
+
+		//! Number of strands taken over from the queue of another worker
+		uint64_t steals{0};
+	};
+
+	//! Throughput of a single rung of an encoding ladder
+	struct RungStats
+	{
+		//! Size of the encoded video
+		unsigned int width{0};
+		unsigned int height{0};
+
+		//! Number of images encoded
+		uint64_t frames{0};
+
+		//! Time spent downscaling the images of the rung
+		std::chrono::nanoseconds scale_time{0};
+
+		//! Time spent encoding and writing the images of the rung
+		std::chrono::nanoseconds encode_time{0};
+
+		//! \returns the number of images processed per second of busy time
+		double framesPerSecond() const
+		{
+			const auto busy = std::chrono::duration<double>(scale_time + encode_time).count();
+			return busy > 0 ? static_cast<double>(frames) / busy : 0.0;
+		}
+	};
+
+	//! Lock-free latency histogram
+	//! Values are sorted into logarithmic buckets with eight linear
+	//! sub-buckets each, thus percentiles are accurate within 12.5%.
+	//! Recording is wait-free; a single writer and concurrent readers are
+	//! supported.
+	class VCL_GRAPHICS_RECORDER_API LatencyHistogram
+	{
+	public:
+		LatencyHistogram();
+
+		//! Add a measurement
+		void record(std::chrono::nanoseconds latency);
+
+		//! Remove all measurements
+		void reset();
+
+		//! Summarize the recorded measurements
+		StageStats summary() const;
+
+	private:
+		//! Number of linear sub-buckets per power of two
+		static const int SubBucketBits = 3;
+
+		//! Values below are stored exactly
+		static const uint64_t LinearLimit = 16;
+
+		//! Number of buckets covering latencies up to 2^40 ns (~18 minutes)
+		static const size_t BucketCount = LinearLimit + (40 - 4) * (1 << SubBucketBits);
+
+		static size_t bucketIndex(uint64_t ns);
+		static uint64_t bucketUpperBound(size_t index);
+
+		std::array<std::atomic<uint64_t>, BucketCount> _buckets;
+		std::atomic<uint64_t> _count;
+		std::atomic<uint64_t> _total;
+		std::atomic<uint64_t> _max;
+	};
+
+	//! Measure the lifetime of the object and record it in a histogram
+	//! Does not access the clock if no histogram is passed.
+	class ScopedStageTimer
+	{
+	public:
+		explicit ScopedStageTimer(LatencyHistogram* histogram)
+		: _histogram(histogram)
+		{
+			if (_histogram)
+				_start = std::chrono::steady_clock::now();
+		}
+
+		~ScopedStageTimer()
+		{
+			if (_histogram)
+				_histogram->record(std::chrono::steady_clock::now() - _start);
+		}
+
+		ScopedStageTimer(const ScopedStageTimer&) = delete;
+		ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+	private:
+		LatencyHistogram* _histogram;
+		std::chrono::steady_clock::time_point _start;
+	};
+}}}
@@ -0,0 +1,103 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "threadaffinity.h"
+
+#if defined(_WIN32)
+#	define NOMINMAX
+#	define WIN32_LEAN_AND_MEAN
+#	include <windows.h>
+#elif defined(__linux__)
+#	include <pthread.h>
+#	include <sched.h>
+#endif
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	namespace
+	{
+		//! Query the CPUs the calling thread may run on
+		std::vector<unsigned int> threadAffinity()
+		{
+			std::vector<unsigned int> cpus;
+#if defined(_WIN32)
+			// Windows can only query the affinity by setting it
+			const DWORD_PTR previous = SetThreadAffinityMask(GetCurrentThread(), ~DWORD_PTR(0));
+			if (previous != 0)
+			{
+				SetThreadAffinityMask(GetCurrentThread(), previous);
+				for (unsigned int cpu = 0; cpu < 8 * sizeof(DWORD_PTR); cpu++)
+					if (previous & (DWORD_PTR(1) << cpu))
+						cpus.push_back(cpu);
+			}
+#elif defined(__linux__)
+			cpu_set_t set;
+			CPU_ZERO(&set);
+			if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) == 0)
+			{
+				for (unsigned int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+					if (CPU_ISSET(cpu, &set))
+						cpus.push_back(cpu);
+			}
+#endif
+			return cpus;
+		}
+	}
+
+	bool setThreadAffinity(const std::vector<unsigned int>& cpus)
+	{
+		if (cpus.empty())
+			return false;
+
+#if defined(_WIN32)
+		DWORD_PTR mask = 0;
+		for (auto cpu : cpus)
+			if (cpu < 8 * sizeof(DWORD_PTR))
+				mask |= DWORD_PTR(1) << cpu;
+		return mask != 0 && SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		for (auto cpu : cpus)
+			if (cpu < CPU_SETSIZE)
+				CPU_SET(cpu, &set);
+		return CPU_COUNT(&set) > 0 && pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+		return false;
+#endif
+	}
+
+	ScopedThreadAffinity::ScopedThreadAffinity(const std::vector<unsigned int>& cpus)
+	{
+		if (cpus.empty())
+			return;
+
+		_previous = threadAffinity();
+		_restore = !_previous.empty() && setThreadAffinity(cpus);
+	}
+
+	ScopedThreadAffinity::~ScopedThreadAffinity()
+	{
+		if (_restore)
+			setThreadAffinity(_previous);
+	}
+}}}
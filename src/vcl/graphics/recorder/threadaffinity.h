@@ -0,0 +1,55 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <vector>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Restrict the calling thread to a set of CPUs
+	//! \param cpus Indices of the allowed CPUs. An empty set is ignored.
+	//! \returns true if the affinity was changed
+	bool setThreadAffinity(const std::vector<unsigned int>& cpus);
+
+	//! Restricts the calling thread to a set of CPUs for the lifetime of
+	//! the object and restores the previous affinity afterwards.
+	//! On Linux threads created in the scope inherit the affinity, which
+	//! is used to restrict the threads spawned by an encoder when it is
+	//! opened. On Windows new threads use the process affinity instead.
+	class ScopedThreadAffinity
+	{
+	public:
+		explicit ScopedThreadAffinity(const std::vector<unsigned int>& cpus);
+		ScopedThreadAffinity(const ScopedThreadAffinity&) = delete;
+		ScopedThreadAffinity& operator=(const ScopedThreadAffinity&) = delete;
+		~ScopedThreadAffinity();
+
+	private:
+		//! Previous affinity of the thread
+		std::vector<unsigned int> _previous;
+
+		//! Affinity needs to be restored
+		bool _restore{false};
+	};
+}}}
@@ -0,0 +1,126 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include "threadpool.h"
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	ThreadPool::ThreadPool(unsigned int threads)
+	{
+		_workers.reserve(threads);
+		for (unsigned int i = 0; i < threads; i++)
+			_workers.emplace_back([this]() { run(); });
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_shutdown = true;
+		}
+		_start.notify_all();
+
+		for (auto& worker : _workers)
+			worker.join();
+	}
+
+	void ThreadPool::parallelFor(unsigned int count, const std::function<void(unsigned int)>& func)
+	{
+		if (count == 0)
+			return;
+
+		// Without workers, or a single task, there is nothing to distribute
+		if (_workers.empty() || count == 1)
+		{
+			for (unsigned int i = 0; i < count; i++)
+				func(i);
+			return;
+		}
+
+		std::lock_guard<std::mutex> loop_lock{ _loopMutex };
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_func = &func;
+			_count = count;
+			_next = 0;
+			_completed = 0;
+			_generation++;
+		}
+		_start.notify_all();
+
+		// Participate in the loop
+		work();
+
+		// Wait until all tasks are done and no worker references the loop anymore
+		std::unique_lock<std::mutex> lock{ _mutex };
+		_done.wait(lock, [this]() { return _completed == _count && _active == 0; });
+		_func = nullptr;
+	}
+
+	void ThreadPool::run()
+	{
+		uint64_t generation = 0;
+		for (;;)
+		{
+			{
+				std::unique_lock<std::mutex> lock{ _mutex };
+				_start.wait(lock, [this, generation]() { return _shutdown || _generation != generation; });
+				if (_shutdown)
+					return;
+				generation = _generation;
+
+				// The loop was already completed by the other threads
+				if (_func == nullptr)
+					continue;
+				_active++;
+			}
+
+			work();
+
+			bool notify = false;
+			{
+				std::lock_guard<std::mutex> lock{ _mutex };
+				_active--;
+				notify = _active == 0 && _completed == _count;
+			}
+			if (notify)
+				_done.notify_one();
+		}
+	}
+
+	void ThreadPool::work()
+	{
+		unsigned int completed = 0;
+		const auto* func = _func;
+		for (unsigned int i = _next++; i < _count; i = _next++)
+		{
+			(*func)(i);
+			completed++;
+		}
+
+		if (completed > 0)
+		{
+			std::lock_guard<std::mutex> lock{ _mutex };
+			_completed += completed;
+		}
+	}
+}}}
@@ -0,0 +1,100 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#pragma once
+
+// C++ standard library
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// VCL
+#include <vcl/graphics/recorder/config.h>
+
+namespace Vcl { namespace Graphics { namespace Recorder
+{
+	//! Fixed set of worker threads executing data-parallel loops
+	class VCL_GRAPHICS_RECORDER_API ThreadPool
+	{
+	public:
+		//! Create the pool
+		//! \param threads Number of worker threads. The thread calling
+		//!                'parallelFor' participates in the work in addition.
+		explicit ThreadPool(unsigned int threads);
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		~ThreadPool();
+
+		//! \returns the number of worker threads
+		unsigned int size() const { return static_cast<unsigned int>(_workers.size()); }
+
+		//! Execute 'func(i)' for every i in [0, count) and wait for completion
+		//! \note Concurrent calls are serialized
+		void parallelFor(unsigned int count, const std::function<void(unsigned int)>& func);
+
+	private:
+		//! Worker thread function
+		void run();
+
+		//! Execute tasks of the current loop until all are taken
+		void work();
+
+		//! Worker threads
+		std::vector<std::thread> _workers;
+
+		//! Serializes calls to 'parallelFor'
+		std::mutex _loopMutex;
+
+		//! Protects the loop state
+		std::mutex _mutex;
+
+		//! Signals the start of a loop or the shutdown
+		std::condition_variable _start;
+
+		//! Signals the completion of a loop
+		std::condition_variable _done;
+
+		//! Function executed by the current loop
+		const std::function<void(unsigned int)>* _func{nullptr};
+
+		//! Number of tasks of the current loop
+		unsigned int _count{0};
+
+		//! Next task to execute
+		std::atomic<unsigned int> _next{0};
+
+		//! Number of completed tasks
+		unsigned int _completed{0};
+
+		//! Number of workers executing tasks of the current loop
+		unsigned int _active{0};
+
+		//! Incremented for every loop to wake the workers
+		uint64_t _generation{0};
+
+		//! Stop the workers
+		bool _shutdown{false};
+	};
+}}}
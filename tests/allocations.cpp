@@ -0,0 +1,150 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+// Count all C++ heap allocations of the test executable and the library.
+// The library is built as shared library. On ELF platforms it resolves the
+// global operator new to the replacement in the executable, but a Windows DLL
+// uses the operators of its own CRT. Its allocations would not be counted and the
+// check would pass regardless, thus only the pool counters are checked there.
+#ifndef _WIN32
+#	define VCL_COUNT_CXX_ALLOCATIONS
+#endif
+
+#ifdef VCL_COUNT_CXX_ALLOCATIONS
+namespace
+{
+	//! Number of allocations through the global operator new
+	std::atomic<uint64_t> CxxAllocations{ 0 };
+}
+
+void* operator new(std::size_t size)
+{
+	CxxAllocations++;
+	if (void* ptr = std::malloc(size > 0 ? size : 1))
+		return ptr;
+	throw std::bad_alloc{};
+}
+void* operator new[](std::size_t size)
+{
+	return operator new(size);
+}
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr) noexcept
+{
+	std::free(ptr);
+}
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+#endif
+
+namespace
+{
+	enum class Input
+	{
+		Yuv420P,
+		Bgra
+	};
+
+	//! Record 1000 frames after warming up and check that no allocations
+	//! were performed by the recorder in the steady state.
+	void checkSteadyState(bool async, Input input)
+	{
+		const int w = 320, h = 240;
+		std::vector<uint8_t> Y(w * h, 255);
+		std::vector<uint8_t> U(w * h / 4, 0);
+		std::vector<uint8_t> V(w * h / 4, 0);
+		std::vector<std::array<uint8_t, 4>> bgra(w * h, { 0, 128, 255, 255 });
+
+		Recorder rec{ OutputFormat::Mkv, CodecType::H264, EncoderSettings{ EncoderProfile::Realtime } };
+		rec.setAsyncEncoding(async, 4);
+		rec.setConversionSlices(2);
+		rec.open(std::make_shared<NullSink>(), w, h, 25);
+
+		auto write = [&](int i)
+		{
+			std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i));
+			bgra[i % bgra.size()][0] = static_cast<uint8_t>(i);
+			if (input == Input::Yuv420P)
+				return rec.write(Y, U, V);
+			else
+				return rec.write(bgra, w, h);
+		};
+
+		// Warm up the pools and the encoder
+		for (int i = 0; i < 100; i++)
+			ASSERT_TRUE(write(i));
+
+		const uint64_t pool_allocations = rec.stats().allocations;
+#ifdef VCL_COUNT_CXX_ALLOCATIONS
+		const uint64_t cxx_allocations = CxxAllocations;
+#endif
+		for (int i = 0; i < 1000; i++)
+			ASSERT_TRUE(write(i));
+		EXPECT_EQ(pool_allocations, rec.stats().allocations);
+#ifdef VCL_COUNT_CXX_ALLOCATIONS
+		EXPECT_EQ(cxx_allocations, CxxAllocations);
+#endif
+
+		rec.close();
+		EXPECT_EQ(1100u, rec.stats().packets);
+	}
+}
+
+TEST(RecorderTest, NoAllocationsInSteadyStateSyncYuv)
+{
+	checkSteadyState(false, Input::Yuv420P);
+}
+TEST(RecorderTest, NoAllocationsInSteadyStateSyncBgra)
+{
+	checkSteadyState(false, Input::Bgra);
+}
+TEST(RecorderTest, NoAllocationsInSteadyStateAsyncYuv)
+{
+	checkSteadyState(true, Input::Yuv420P);
+}
+TEST(RecorderTest, NoAllocationsInSteadyStateAsyncBgra)
+{
+	checkSteadyState(true, Input::Bgra);
+}
@@ -0,0 +1,72 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, AsyncSequenceOutputMkvH264)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.setAsyncEncoding(true, 4);
+	rec.open("async_sequence.mkv", 256, 256, 1);
+
+	for (int i = 0; i <= 10; i++)
+	{
+		// The recorder copies the frame, thus the input can be modified immediately
+		std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * (255.0f / 10.0f)));
+		EXPECT_TRUE(rec.write(Y, U, V));
+	}
+	rec.close();
+}
+TEST(RecorderTest, AsyncSequenceOutputMp4H264)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mp4, CodecType::H264 };
+	rec.setAsyncEncoding(true, 4);
+	rec.open("async_sequence.mp4", 256, 256, 1);
+
+	for (int i = 0; i <= 10; i++)
+	{
+		std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * (255.0f / 10.0f)));
+		EXPECT_TRUE(rec.write(Y, U, V));
+	}
+}
+TEST(RecorderTest, AsyncModeLockedWhileOpen)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.setAsyncEncoding(true);
+	rec.open("async_locked.mkv", 256, 256, 25);
+
+	EXPECT_THROW(rec.setAsyncEncoding(false), std::runtime_error);
+}
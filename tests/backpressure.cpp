@@ -0,0 +1,130 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	//! Sink simulating a slow output by blocking writes on request
+	class StallingSink
+	{
+	public:
+		std::shared_ptr<OutputSink> sink()
+		{
+			return std::make_shared<CallbackSink>([this](const uint8_t*, size_t) {
+				std::unique_lock<std::mutex> lock{ _mutex };
+				_cv.wait(lock, [this]() { return !_stalled; });
+				return true;
+			});
+		}
+
+		void stall(bool stalled)
+		{
+			{
+				std::lock_guard<std::mutex> lock{ _mutex };
+				_stalled = stalled;
+			}
+			_cv.notify_all();
+		}
+
+	private:
+		std::mutex _mutex;
+		std::condition_variable _cv;
+		bool _stalled{ false };
+	};
+
+	void recordWithStalledOutput(OverflowPolicy policy)
+	{
+		const int width = 256;
+		const int height = 256;
+		const int frames = 50;
+
+		// Noise prevents the encoder from compressing the frames,
+		// thus each packet is flushed to the sink
+		std::mt19937 rnd{ 42 };
+		std::uniform_int_distribution<int> dist{ 0, 255 };
+		std::vector<uint8_t> Y(width * height);
+		std::vector<uint8_t> U(width * height / 4, 128);
+		std::vector<uint8_t> V(width * height / 4, 128);
+		for (auto& y : Y)
+			y = static_cast<uint8_t>(dist(rnd));
+
+		StallingSink output;
+		Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+		rec.setAsyncEncoding(true, 2);
+		rec.setOverflowPolicy(policy);
+		EXPECT_EQ(rec.overflowPolicy(), policy);
+		rec.open(output.sink(), width, height, 25);
+		EXPECT_THROW(rec.setOverflowPolicy(OverflowPolicy::Block), std::runtime_error);
+
+		output.stall(true);
+		for (int i = 0; i < frames; i++)
+		{
+			// Dropped frames are not an error
+			EXPECT_TRUE(rec.write(Y, U, V));
+		}
+
+		// The pipeline is stuck, thus the queue stays full
+		EXPECT_FALSE(rec.canAccept());
+		EXPECT_GT(rec.stats().overflow_frames, 0u);
+
+		output.stall(false);
+		rec.close();
+
+		// Every frame was either encoded or dropped
+		const auto stats = rec.stats();
+		EXPECT_EQ(stats.packets + stats.overflow_frames, static_cast<uint64_t>(frames));
+	}
+}
+
+TEST(RecorderTest, OverflowDropNewest)
+{
+	recordWithStalledOutput(OverflowPolicy::DropNewest);
+}
+TEST(RecorderTest, OverflowDropOldest)
+{
+	recordWithStalledOutput(OverflowPolicy::DropOldest);
+}
+TEST(RecorderTest, OverflowDropNonReference)
+{
+	recordWithStalledOutput(OverflowPolicy::DropNonReference);
+}
+TEST(RecorderTest, CanAcceptSynchronous)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_FALSE(rec.canAccept()) << "Recorder is not open";
+
+	rec.open("can_accept.mkv", 256, 256, 25);
+	EXPECT_TRUE(rec.canAccept());
+	rec.close();
+}
@@ -0,0 +1,149 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <vcl/graphics/recorder/chunkedencoder.h>
+
+#include "testhelpers.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	//! Images with a brightness depending on their index
+	class RampSource : public FrameSource
+	{
+	public:
+		explicit RampSource(uint64_t frames) : _frames(frames) {}
+
+		uint64_t frameCount() const override { return _frames; }
+
+		FrameView read(uint64_t index, std::vector<uint8_t>& buffer) override
+		{
+			buffer.resize(Size * Size * 3 / 2);
+			std::fill(buffer.begin(), buffer.begin() + Size * Size, static_cast<uint8_t>(index * 5));
+			std::fill(buffer.begin() + Size * Size, buffer.end(), 128);
+
+			const uint8_t* y = buffer.data();
+			const uint8_t* u = y + Size * Size;
+			const uint8_t* v = u + Size * Size / 4;
+			return FrameView::yuv420p
+			(
+				{ y, Size * Size }, Size,
+				{ u, Size * Size / 4 }, Size / 2,
+				{ v, Size * Size / 4 }, Size / 2,
+				Size, Size
+			);
+		}
+
+		static const int Size = 64;
+
+	private:
+		uint64_t _frames;
+	};
+
+	//! Read the timestamps of the video stream in frame intervals
+	void readTimestamps(const char* path, int fps, std::vector<int64_t>& pts, std::vector<int64_t>& dts)
+	{
+		AVFormatContext* ctx = nullptr;
+		ASSERT_GE(avformat_open_input(&ctx, path, nullptr, nullptr), 0);
+		ASSERT_GE(avformat_find_stream_info(ctx, nullptr), 0);
+
+		const AVRational frame_tb{ 1, fps };
+		AVPacket* pkt = av_packet_alloc();
+		while (av_read_frame(ctx, pkt) >= 0)
+		{
+			const AVRational tb = ctx->streams[pkt->stream_index]->time_base;
+			pts.push_back(av_rescale_q(pkt->pts, tb, frame_tb));
+			dts.push_back(av_rescale_q(pkt->dts, tb, frame_tb));
+			av_packet_unref(pkt);
+		}
+		av_packet_free(&pkt);
+		avformat_close_input(&ctx);
+	}
+}
+
+TEST(RecorderTest, ChunkedContinuousTimestamps)
+{
+	RampSource source{ 20 };
+
+	ChunkOptions options;
+	options.chunk_frames = 7;
+	options.threads = 3;
+
+	ChunkedEncoder encoder{ OutputFormat::Mkv, CodecType::Ffv1 };
+	encoder.setChunkOptions(options);
+	EXPECT_EQ(encoder.encode(source, "chunked_ffv1.mkv", RampSource::Size, RampSource::Size, 25), 20u);
+
+	std::vector<int64_t> pts, dts;
+	readTimestamps("chunked_ffv1.mkv", 25, pts, dts);
+	ASSERT_EQ(pts.size(), 20u);
+	for (size_t i = 0; i < pts.size(); i++)
+		EXPECT_EQ(pts[i], static_cast<int64_t>(i));
+}
+TEST(RecorderTest, ChunkedMp4H264)
+{
+	if (!hasEncoder(CodecType::H264, "libx264"))
+		GTEST_SKIP() << "libx264 is not available";
+
+	RampSource source{ 50 };
+
+	ChunkOptions options;
+	options.chunk_frames = 12;
+	options.threads = 2;
+
+	ChunkedEncoder encoder{ OutputFormat::Mp4, CodecType::H264 };
+	encoder.setChunkOptions(options);
+	EXPECT_EQ(encoder.encode(source, "chunked_h264.mp4", RampSource::Size, RampSource::Size, 25), 50u);
+
+	// Reordered frames only change the presentation order within a chunk
+	std::vector<int64_t> pts, dts;
+	readTimestamps("chunked_h264.mp4", 25, pts, dts);
+	ASSERT_EQ(pts.size(), 50u);
+	EXPECT_TRUE(std::is_sorted(dts.begin(), dts.end()));
+	EXPECT_EQ(std::adjacent_find(dts.begin(), dts.end()), dts.end());
+
+	std::sort(pts.begin(), pts.end());
+	for (size_t i = 1; i < pts.size(); i++)
+		EXPECT_EQ(pts[i] - pts[i - 1], 1);
+}
+TEST(RecorderTest, ChunkedValidation)
+{
+	ChunkedEncoder encoder{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_THROW(encoder.setChunkOptions(ChunkOptions{ 0, 1 }), std::domain_error);
+
+	RampSource empty{ 0 };
+	EXPECT_THROW(encoder.encode(empty, "chunked_empty.mkv", 64, 64, 25), std::domain_error);
+
+	EXPECT_THROW(ChunkedEncoder(OutputFormat::Mp4, CodecType::Ffv1), std::domain_error);
+}
@@ -0,0 +1,186 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	//! Record a short sequence into a sink
+	//! \returns the number of packets written or -1 if the recorder could not be opened
+	int recordSequence(OutputFormat fmt, CodecType codec, const std::string& encoder)
+	{
+		std::vector<uint8_t> Y(256 * 256, 255);
+		std::vector<uint8_t> U(128 * 128, 0);
+		std::vector<uint8_t> V(128 * 128, 0);
+
+		std::unique_ptr<Recorder> rec;
+		try
+		{
+			rec = std::make_unique<Recorder>(fmt, codec, encoder);
+			rec->setEncoderSettings(EncoderProfile::Realtime);
+			rec->open(std::make_shared<NullSink>(), 256, 256, 25);
+		}
+		catch (const std::exception&)
+		{
+			// Hardware encoders are listed without a device being present
+			// and not every FFmpeg version can store all codecs in a container.
+			return -1;
+		}
+
+		for (int i = 0; i <= 10; i++)
+		{
+			std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * (255.0f / 10.0f)));
+			EXPECT_TRUE(rec->write(Y, U, V)) << encoder;
+		}
+		rec->close();
+
+		return static_cast<int>(rec->stats().packets);
+	}
+}
+
+TEST(RecorderTest, Ffv1IsAlwaysAvailable)
+{
+	// FFV1 is implemented by FFmpeg itself
+	const auto encoders = Recorder::availableEncoders(CodecType::Ffv1);
+	ASSERT_EQ(1u, encoders.size());
+	EXPECT_EQ("ffv1", encoders[0]);
+}
+TEST(RecorderTest, SequenceOutputMkvFfv1)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_STREQ("ffv1", rec.encoderName());
+	rec.open("sequence_ffv1.mkv", 256, 256, 1);
+
+	for (int i = 0; i <= 10; i++)
+	{
+		std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * (255.0f / 10.0f)));
+		EXPECT_TRUE(rec.write(Y, U, V));
+	}
+	rec.close();
+
+	// Intra-only coding emits one packet per frame
+	EXPECT_EQ(11u, rec.stats().packets);
+}
+TEST(RecorderTest, SequenceOutputAviFfv1)
+{
+	EXPECT_EQ(11, recordSequence(OutputFormat::Avi, CodecType::Ffv1, "ffv1"));
+}
+TEST(RecorderTest, RgbInputFfv1)
+{
+	std::vector<std::array<uint8_t, 4>> bgra(256 * 256, { 0, 128, 255, 255 });
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+	for (int i = 0; i < 5; i++)
+		EXPECT_TRUE(rec.write(bgra, 256, 256));
+	rec.close();
+
+	EXPECT_EQ(5u, rec.stats().packets);
+}
+TEST(RecorderTest, ContainerCompatibility)
+{
+	// MP4 cannot store FFV1
+	EXPECT_THROW(Recorder(OutputFormat::Mp4, CodecType::Ffv1), std::domain_error);
+	EXPECT_NO_THROW(Recorder(OutputFormat::Mkv, CodecType::Ffv1));
+	EXPECT_NO_THROW(Recorder(OutputFormat::Avi, CodecType::Ffv1));
+}
+TEST(RecorderTest, EncoderMustMatchCodec)
+{
+	EXPECT_THROW(Recorder(OutputFormat::Mkv, CodecType::H264, "ffv1"), std::domain_error);
+}
+TEST(RecorderTest, AllAvailableEncoders)
+{
+	for (const auto codec : { CodecType::H264, CodecType::Hevc, CodecType::Vp9, CodecType::Av1, CodecType::Ffv1 })
+	{
+		for (const auto& encoder : Recorder::availableEncoders(codec))
+		{
+			const int packets = recordSequence(OutputFormat::Mkv, codec, encoder);
+			if (packets >= 0)
+			{
+				EXPECT_GT(packets, 0) << encoder;
+			}
+		}
+	}
+}
+TEST(RecorderTest, NonDefaultEncoderSettings)
+{
+	// Encoders other than the candidates only receive the shared settings.
+	// They might still fail to open, e.g. hardware encoders without device.
+	const std::array<std::pair<CodecType, AVCodecID>, 2> codecs =
+	{{
+		{ CodecType::Vp9, AV_CODEC_ID_VP9 },
+		{ CodecType::Av1, AV_CODEC_ID_AV1 }
+	}};
+
+	int tested = 0;
+	void* iter = nullptr;
+	while (const AVCodec* codec = av_codec_iterate(&iter))
+	{
+		if (!av_codec_is_encoder(codec))
+			continue;
+
+		for (const auto& entry : codecs)
+		{
+			if (codec->id != entry.second || codec->name == std::string{ "libvpx-vp9" } || codec->name == std::string{ "libaom-av1" })
+				continue;
+
+			try
+			{
+				Recorder rec{ OutputFormat::Mkv, entry.first, codec->name };
+				rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+			}
+			catch (const std::domain_error&)
+			{
+				// Not every FFmpeg version can store all codecs in a container
+				continue;
+			}
+			catch (const std::runtime_error& e)
+			{
+				EXPECT_EQ(std::string::npos, std::string{ e.what() }.find("AV set option")) << codec->name;
+			}
+			tested++;
+		}
+	}
+
+	if (tested == 0)
+		GTEST_SKIP() << "No alternative VP9 or AV1 encoder is available";
+}
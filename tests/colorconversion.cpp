@@ -0,0 +1,220 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+// C++ standard library
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include <vcl/graphics/recorder/colorconversion.h>
+#include <vcl/graphics/recorder/frameconverter.h>
+
+extern "C"
+{
+#include <libavutil/frame.h>
+#include <libswscale/swscale.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	int bytesPerPixel(PixelFormat fmt)
+	{
+		return fmt == PixelFormat::Bgra ? 4 : 3;
+	}
+
+	//! Destination planes of a YUV 4:2:0 image
+	struct YuvImage
+	{
+		YuvImage(PixelFormat fmt, int w, int h)
+		: format(fmt)
+		, width(w)
+		, height(h)
+		{
+			const int cw = (w + 1) / 2;
+			const int ch = (h + 1) / 2;
+			stride[0] = w;
+			stride[1] = fmt == PixelFormat::Nv12 ? 2 * cw : cw;
+			stride[2] = fmt == PixelFormat::Nv12 ? 0 : cw;
+			for (int i = 0; i < 3; i++)
+				planes[i].resize(stride[i] * (i == 0 ? h : ch));
+		}
+
+		ConversionParams params(PixelFormat src_fmt, const std::vector<uint8_t>& src, ColorMatrix matrix)
+		{
+			ConversionParams p;
+			p.src_format = src_fmt;
+			p.src = src.data();
+			p.src_stride = width * bytesPerPixel(src_fmt);
+			p.width = width;
+			p.height = height;
+			p.dst_format = format;
+			for (int i = 0; i < 3; i++)
+			{
+				p.dst[i] = planes[i].empty() ? nullptr : planes[i].data();
+				p.dst_stride[i] = stride[i];
+			}
+			p.matrix = matrix;
+			return p;
+		}
+
+		PixelFormat format;
+		int width;
+		int height;
+		int stride[3];
+		std::vector<uint8_t> planes[3];
+	};
+
+	int maxError(const std::vector<uint8_t>& a, const std::vector<uint8_t>& b)
+	{
+		int err = 0;
+		for (size_t i = 0; i < a.size(); i++)
+			err = std::max(err, std::abs(a[i] - b[i]));
+		return err;
+	}
+}
+
+class ColorConversionTest : public ::testing::TestWithParam<std::tuple<PixelFormat, PixelFormat, ColorMatrix>>
+{
+};
+
+TEST_P(ColorConversionTest, KernelsAreBitExact)
+{
+	const auto src_fmt = std::get<0>(GetParam());
+	const auto dst_fmt = std::get<1>(GetParam());
+	const auto matrix = std::get<2>(GetParam());
+	const auto max_level = detectSimdLevel();
+
+	std::mt19937 rng{ 5489u };
+	for (const auto& size : { std::make_pair(256, 128), std::make_pair(37, 19), std::make_pair(1, 1) })
+	{
+		const int w = size.first;
+		const int h = size.second;
+		std::vector<uint8_t> src(w * h * bytesPerPixel(src_fmt));
+		std::generate(std::begin(src), std::end(src), [&rng]() { return static_cast<uint8_t>(rng()); });
+
+		YuvImage ref{ dst_fmt, w, h };
+		convertRows(SimdLevel::Scalar, ref.params(src_fmt, src, matrix), 0, h);
+
+		for (auto level : { SimdLevel::Sse41, SimdLevel::Avx2 })
+		{
+			if (level > max_level)
+				continue;
+
+			YuvImage img{ dst_fmt, w, h };
+			convertRows(level, img.params(src_fmt, src, matrix), 0, h);
+			for (int i = 0; i < 3; i++)
+				EXPECT_EQ(ref.planes[i], img.planes[i]) << "Plane " << i << ", size " << w << "x" << h;
+		}
+	}
+}
+
+TEST_P(ColorConversionTest, MatchesSwscale)
+{
+	const auto src_fmt = std::get<0>(GetParam());
+	const auto dst_fmt = std::get<1>(GetParam());
+	const auto matrix = std::get<2>(GetParam());
+	const int w = 256;
+	const int h = 128;
+	const int bpp = bytesPerPixel(src_fmt);
+
+	// Smooth content, such that differences in the chroma filtering do not dominate
+	std::vector<uint8_t> src(w * h * bpp, 255);
+	const int r = src_fmt == PixelFormat::Rgb24 ? 0 : 2;
+	const int b = src_fmt == PixelFormat::Rgb24 ? 2 : 0;
+	for (int y = 0; y < h; y++)
+	{
+		for (int x = 0; x < w; x++)
+		{
+			src[(y * w + x) * bpp + r] = static_cast<uint8_t>(x);
+			src[(y * w + x) * bpp + 1] = static_cast<uint8_t>(2 * y);
+			src[(y * w + x) * bpp + b] = static_cast<uint8_t>(255 - x);
+		}
+	}
+
+	YuvImage img{ dst_fmt, w, h };
+	convertRows(detectSimdLevel(), img.params(src_fmt, src, matrix), 0, h);
+
+	YuvImage ref{ dst_fmt, w, h };
+	SwsContext* sws_ctx = sws_getContext(w, h, toAVPixelFormat(src_fmt), w, h, toAVPixelFormat(dst_fmt), SWS_BILINEAR | SWS_ACCURATE_RND, nullptr, nullptr, nullptr);
+	ASSERT_NE(nullptr, sws_ctx);
+	const int* coeffs = sws_getCoefficients(matrix == ColorMatrix::Bt709 ? SWS_CS_ITU709 : SWS_CS_ITU601);
+	sws_setColorspaceDetails(sws_ctx, coeffs, 0, coeffs, 0, 0, 1 << 16, 1 << 16);
+
+	const uint8_t* src_planes[4] = { src.data(), nullptr, nullptr, nullptr };
+	const int src_stride[4] = { w * bpp, 0, 0, 0 };
+	uint8_t* dst_planes[4] = { ref.planes[0].data(), ref.planes[1].data(), ref.planes[2].empty() ? nullptr : ref.planes[2].data(), nullptr };
+	const int dst_stride[4] = { ref.stride[0], ref.stride[1], ref.stride[2], 0 };
+	sws_scale(sws_ctx, src_planes, src_stride, 0, h, dst_planes, dst_stride);
+	sws_freeContext(sws_ctx);
+
+	EXPECT_LE(maxError(ref.planes[0], img.planes[0]), 1);
+	EXPECT_LE(maxError(ref.planes[1], img.planes[1]), 2);
+	EXPECT_LE(maxError(ref.planes[2], img.planes[2]), 2);
+}
+
+INSTANTIATE_TEST_CASE_P(RecorderTest, ColorConversionTest, ::testing::Combine(
+	::testing::Values(PixelFormat::Rgb24, PixelFormat::Bgr24, PixelFormat::Bgra),
+	::testing::Values(PixelFormat::Yuv420P, PixelFormat::Nv12),
+	::testing::Values(ColorMatrix::Bt601, ColorMatrix::Bt709)
+));
+
+TEST(RecorderTest, SlicedConversionIsIdentical)
+{
+	const int w = 640;
+	const int h = 362;
+
+	std::mt19937 rng{ 5489u };
+	std::vector<uint8_t> src(w * h * 4);
+	std::generate(std::begin(src), std::end(src), [&rng]() { return static_cast<uint8_t>(rng()); });
+	const uint8_t* src_planes[4] = { src.data(), nullptr, nullptr, nullptr };
+	const int src_stride[4] = { 4 * w, 0, 0, 0 };
+
+	const auto convert = [&](unsigned int slices)
+	{
+		AVFrame* frame = av_frame_alloc();
+		frame->format = AV_PIX_FMT_NV12;
+		frame->width = w;
+		frame->height = h;
+		av_frame_get_buffer(frame, 32);
+
+		FrameConverter converter;
+		converter.setSliceCount(slices);
+		EXPECT_TRUE(converter.convert(src_planes, src_stride, AV_PIX_FMT_BGRA, w, h, frame));
+
+		std::vector<uint8_t> result;
+		for (int y = 0; y < h; y++)
+			result.insert(result.end(), frame->data[0] + y * frame->linesize[0], frame->data[0] + y * frame->linesize[0] + w);
+		for (int y = 0; y < h / 2; y++)
+			result.insert(result.end(), frame->data[1] + y * frame->linesize[1], frame->data[1] + y * frame->linesize[1] + w);
+		av_frame_free(&frame);
+
+		return result;
+	};
+
+	const auto reference = convert(1);
+	for (unsigned int slices : { 2u, 3u, 4u, 7u, 0u })
+		EXPECT_EQ(reference, convert(slices)) << "Slices: " << slices;
+}
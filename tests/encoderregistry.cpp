@@ -0,0 +1,100 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <vcl/graphics/recorder/encoderregistry.h>
+#include <vcl/graphics/recorder/recorder.h>
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, EncoderRegistryProbe)
+{
+	auto& registry = EncoderRegistry::instance();
+	const auto encoders = registry.encoders(CodecType::Ffv1);
+	ASSERT_EQ(encoders.size(), 1u);
+
+	const auto& ffv1 = encoders.front();
+	EXPECT_EQ(ffv1.name, "ffv1");
+	EXPECT_TRUE(ffv1.available);
+	EXPECT_TRUE(ffv1.usable);
+	EXPECT_EQ(ffv1.input_format, AV_PIX_FMT_YUV420P);
+	EXPECT_NE(std::find(ffv1.pixel_formats.begin(), ffv1.pixel_formats.end(), PixelFormat::Yuv420P), ffv1.pixel_formats.end());
+	EXPECT_EQ(registry.preferredEncoder(CodecType::Ffv1), "ffv1");
+}
+TEST(RecorderTest, EncoderRegistryCachesResults)
+{
+	auto& registry = EncoderRegistry::instance();
+	registry.reset();
+
+	const auto probes = registry.probeCount();
+	registry.encoders(CodecType::Ffv1);
+	EXPECT_EQ(registry.probeCount(), probes + 1);
+
+	// Later queries and recorders use the cached result
+	registry.encoders(CodecType::Ffv1);
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_EQ(Recorder::availableEncoders(CodecType::Ffv1), std::vector<std::string>{ "ffv1" });
+	EXPECT_EQ(registry.probeCount(), probes + 1);
+
+	registry.reset();
+	registry.encoders(CodecType::Ffv1);
+	EXPECT_EQ(registry.probeCount(), probes + 2);
+}
+TEST(RecorderTest, EncoderRegistryOnlySelectsUsable)
+{
+	// Each selected encoder was opened successfully before
+	for (const auto& encoder : EncoderRegistry::instance().encoders(CodecType::H264))
+	{
+		if (!encoder.available)
+			EXPECT_FALSE(encoder.usable);
+	}
+
+	const auto preferred = EncoderRegistry::instance().preferredEncoder(CodecType::H264);
+	if (!preferred.empty())
+	{
+		Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+		EXPECT_EQ(preferred, rec.encoderName());
+		EXPECT_NO_THROW(rec.open("registry_preferred.mkv", 256, 256, 25));
+	}
+}
+TEST(RecorderTest, EncoderRegistryProbesExperimental)
+{
+	// libaom is flagged experimental and needs the same options to be
+	// opened when probing as when recording
+	if (!avcodec_find_encoder_by_name("libaom-av1"))
+		GTEST_SKIP() << "libaom-av1 is not part of the FFmpeg build";
+
+	EXPECT_EQ(EncoderRegistry::instance().preferredEncoder(CodecType::Av1), "libaom-av1");
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Av1 };
+	EXPECT_EQ(rec.encoderName(), "libaom-av1");
+}
@@ -0,0 +1,141 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+
+#include "testhelpers.h"
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, RealtimeProfileHasNoDelay)
+{
+	if (!hasEncoder(CodecType::H264, "libx264"))
+		GTEST_SKIP() << "libx264 is not available";
+
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264, "libx264" };
+	rec.setEncoderSettings(EncoderProfile::Realtime);
+	rec.open("profile_realtime.mkv", 256, 256, 25);
+
+	// Without look-ahead and B-frames each frame is emitted immediately
+	for (int i = 0; i < 5; i++)
+	{
+		EXPECT_TRUE(rec.write(Y, U, V));
+		EXPECT_EQ(static_cast<uint64_t>(i + 1), rec.stats().packets);
+	}
+}
+TEST(RecorderTest, EncoderSettingsOverridesForAllEncoders)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	EncoderSettings settings{ EncoderProfile::Balanced };
+	settings.bit_rate = 1000000;
+	settings.gop_size = 5;
+	settings.max_b_frames = 0;
+	settings.quality = 30;
+
+	for (const auto& encoder : Recorder::availableEncoders(CodecType::H264))
+	{
+		Recorder rec{ OutputFormat::Mkv, CodecType::H264, encoder };
+		rec.setEncoderSettings(settings);
+
+		// Hardware encoders can be listed without a device being present
+		try
+		{
+			rec.open("profile_" + encoder + ".mkv", 256, 256, 25);
+		}
+		catch (const std::runtime_error&)
+		{
+			continue;
+		}
+
+		for (int i = 0; i < 10; i++)
+			EXPECT_TRUE(rec.write(Y, U, V)) << encoder;
+		rec.close();
+		EXPECT_EQ(10u, rec.stats().packets) << encoder;
+	}
+}
+TEST(RecorderTest, EncoderSettingsLockedWhileOpen)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264, EncoderSettings{ EncoderProfile::Realtime } };
+	EXPECT_EQ(EncoderProfile::Realtime, rec.encoderSettings().profile);
+	rec.open("profile_locked.mkv", 256, 256, 25);
+
+	EXPECT_THROW(rec.setEncoderSettings(EncoderProfile::Archive), std::runtime_error);
+}
+TEST(RecorderTest, EncoderSettingsChangeBetweenRecordings)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1, EncoderSettings{ EncoderProfile::Archive } };
+	rec.open("profile_first.mkv", 256, 256, 25);
+	EXPECT_TRUE(rec.write(Y, U, V));
+	rec.close();
+
+	// The second recording opens a new encoder
+	rec.setEncoderSettings(EncoderProfile::Realtime);
+	rec.resetStats();
+	rec.open("profile_second.mkv", 256, 256, 25);
+	for (int i = 0; i < 3; i++)
+		EXPECT_TRUE(rec.write(Y, U, V));
+	rec.close();
+	EXPECT_EQ(3u, rec.stats().packets);
+}
+TEST(RecorderTest, EncoderSettingsApplyAfterReopen)
+{
+	if (!hasEncoder(CodecType::H264, "libx264"))
+		GTEST_SKIP() << "libx264 is not available";
+
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264, "libx264" };
+	rec.setEncoderSettings(EncoderProfile::Archive);
+	rec.open("profile_reopen_first.mkv", 256, 256, 25);
+	EXPECT_TRUE(rec.write(Y, U, V));
+	rec.close();
+
+	// Without look-ahead and B-frames each frame is emitted immediately
+	rec.setEncoderSettings(EncoderProfile::Realtime);
+	rec.resetStats();
+	rec.open("profile_reopen_second.mkv", 256, 256, 25);
+	for (int i = 0; i < 5; i++)
+	{
+		EXPECT_TRUE(rec.write(Y, U, V));
+		EXPECT_EQ(static_cast<uint64_t>(i + 1), rec.stats().packets);
+	}
+	rec.close();
+}
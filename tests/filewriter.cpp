@@ -0,0 +1,121 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+#include <vcl/graphics/recorder/filewriter.h>
+#include <vcl/graphics/recorder/recorder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	std::vector<uint8_t> readFile(const char* path)
+	{
+		std::ifstream file{ path, std::ios::binary };
+		return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+	}
+}
+
+TEST(RecorderTest, FileWriterSeeks)
+{
+	FileWriterOptions options;
+	options.buffer_size = 0;
+	options.preallocate = 1024 * 1024;
+	options.sync = SyncPolicy::OnClose;
+
+	// Exceed the minimal buffer to pass multiple blocks to the writer
+	std::vector<uint8_t> data(1024 * 1024);
+	for (size_t i = 0; i < data.size(); i++)
+		data[i] = static_cast<uint8_t>(i);
+
+	FileWriter writer{ "filewriter_seek.bin", options };
+	EXPECT_TRUE(writer.write(data.data(), data.size()));
+	EXPECT_EQ(4, writer.seek(4, SEEK_SET));
+	const uint8_t patch[] = { 0xff, 0xfe };
+	EXPECT_TRUE(writer.write(patch, sizeof(patch)));
+	EXPECT_EQ(static_cast<int64_t>(data.size()), writer.size());
+	EXPECT_TRUE(writer.close());
+	EXPECT_EQ(1u, writer.stats().syncs);
+	EXPECT_EQ(0u, writer.stats().queue_depth);
+	EXPECT_GT(writer.stats().max_queue_depth, 0u);
+
+	// The preallocated space does not change the size of the file
+	data[4] = 0xff;
+	data[5] = 0xfe;
+	EXPECT_EQ(data, readFile("filewriter_seek.bin"));
+	std::remove("filewriter_seek.bin");
+}
+TEST(RecorderTest, FileWriterPeriodicSync)
+{
+	FileWriterOptions options;
+	options.sync = SyncPolicy::Periodic;
+	options.sync_interval = 64 * 1024;
+	options.buffer_size = 64 * 1024;
+
+	const std::vector<uint8_t> data(64 * 1024, 1);
+	FileWriter writer{ "filewriter_sync.bin", options };
+	for (int i = 0; i < 4; i++)
+		EXPECT_TRUE(writer.write(data.data(), data.size()));
+	EXPECT_TRUE(writer.close());
+
+	// Every block and the close
+	EXPECT_EQ(5u, writer.stats().syncs);
+	std::remove("filewriter_sync.bin");
+}
+TEST(RecorderTest, FileWriterInvalidPath)
+{
+	EXPECT_THROW(FileWriter("does/not/exist/file.bin", {}), std::runtime_error);
+}
+TEST(RecorderTest, BufferedWriterRecording)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	FileWriterOptions options;
+	options.buffer_size = 4 * 1024 * 1024;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setBufferedWriter(true, options);
+	EXPECT_TRUE(rec.isBufferedWriter());
+	rec.open("buffered_writer.mkv", 256, 256, 25);
+	for (int i = 0; i < 25; i++)
+	{
+		std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i));
+		EXPECT_TRUE(rec.write(Y, U, V));
+	}
+	rec.close();
+
+	const auto stats = rec.stats();
+	EXPECT_EQ(0u, stats.writer.queue_depth);
+	EXPECT_GT(stats.writer.max_queue_depth, 0u);
+
+	const auto data = readFile("buffered_writer.mkv");
+	EXPECT_GT(data.size(), stats.bytes_written);
+}
@@ -0,0 +1,111 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	//! Position of the first box of a type or -1
+	ptrdiff_t findBox(const std::vector<uint8_t>& data, const char* type)
+	{
+		const auto it = std::search(data.begin(), data.end(), type, type + 4);
+		return it == data.end() ? -1 : std::distance(data.begin(), it);
+	}
+
+	//! Record into a sink only supporting appending
+	std::vector<uint8_t> recordAppendOnly(Mp4Options mp4)
+	{
+		std::vector<uint8_t> Y(256 * 256, 255);
+		std::vector<uint8_t> U(128 * 128, 0);
+		std::vector<uint8_t> V(128 * 128, 0);
+
+		std::vector<uint8_t> data;
+		auto sink = std::make_shared<CallbackSink>([&data](const uint8_t* buf, size_t size)
+		{
+			data.insert(data.end(), buf, buf + size);
+			return true;
+		});
+
+		EncoderSettings settings{ EncoderProfile::Realtime };
+		settings.gop_size = 5;
+
+		Recorder rec{ OutputFormat::Mp4, CodecType::H264, settings };
+		rec.setMp4Options(mp4);
+		rec.open(sink, 256, 256, 25);
+		for (int i = 0; i < 20; i++)
+		{
+			std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * 10));
+			EXPECT_TRUE(rec.write(Y, U, V));
+		}
+		rec.close();
+
+		return data;
+	}
+}
+
+TEST(RecorderTest, FragmentedMp4WithoutSeeking)
+{
+	Mp4Options mp4;
+	mp4.layout = Mp4Layout::Fragmented;
+	const auto data = recordAppendOnly(mp4);
+
+	// The index precedes the fragments
+	const auto moov = findBox(data, "moov");
+	const auto moof = findBox(data, "moof");
+	ASSERT_GE(moov, 0);
+	ASSERT_GE(moof, 0);
+	EXPECT_LT(moov, moof);
+}
+TEST(RecorderTest, FragmentedMp4ByDuration)
+{
+	Mp4Options mp4;
+	mp4.layout = Mp4Layout::Fragmented;
+	mp4.fragment_duration = std::chrono::milliseconds(400);
+	const auto data = recordAppendOnly(mp4);
+
+	EXPECT_GE(findBox(data, "moof"), 0);
+}
+TEST(RecorderTest, Mp4RequiresSeekingUnlessFragmented)
+{
+	Mp4Options mp4;
+	mp4.layout = Mp4Layout::Default;
+	EXPECT_THROW(recordAppendOnly(mp4), std::runtime_error);
+}
+TEST(RecorderTest, Mp4OptionsFixedWhileOpen)
+{
+	Recorder rec{ OutputFormat::Mp4, CodecType::H264 };
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+	EXPECT_THROW(rec.setMp4Options({}), std::runtime_error);
+	rec.close();
+	EXPECT_NO_THROW(rec.setMp4Options({}));
+}
@@ -0,0 +1,91 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, FrameViewPaddedYuv420P)
+{
+	// Rows aligned to 64 bytes, as delivered by many capture APIs
+	const int w = 200, h = 100;
+	const int y_stride = 256, c_stride = 128;
+	std::vector<uint8_t> Y(y_stride * h, 255);
+	std::vector<uint8_t> U(c_stride * h / 2, 0);
+	std::vector<uint8_t> V(c_stride * h / 2, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.open("frameview_yuv420p.mkv", w, h, 25);
+	for (int i = 0; i <= 10; i++)
+	{
+		std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * (255.0f / 10.0f)));
+		EXPECT_TRUE(rec.write(FrameView::yuv420p(Y, y_stride, U, c_stride, V, c_stride, w, h)));
+	}
+	rec.close();
+	EXPECT_EQ(11u, rec.stats().packets);
+}
+TEST(RecorderTest, FrameViewPaddedBgra)
+{
+	const int w = 200, h = 100;
+	const int stride = 4 * 256;
+	std::vector<uint8_t> bgra(stride * h, 128);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.open(std::make_shared<NullSink>(), w, h, 25);
+	for (int i = 0; i < 5; i++)
+		EXPECT_TRUE(rec.write(FrameView::packed(bgra, stride, PixelFormat::Bgra, w, h)));
+}
+TEST(RecorderTest, FrameViewLastRowUnpadded)
+{
+	// The padding of the last row can be omitted
+	std::vector<uint8_t> rgb(1024 + 3 * 100);
+	EXPECT_NO_THROW(FrameView::packed(rgb, 1024, PixelFormat::Rgb24, 100, 2).validate());
+
+	const gsl::span<const uint8_t> truncated{ rgb.data(), 1024 + 3 * 100 - 1 };
+	EXPECT_THROW(FrameView::packed(truncated, 1024, PixelFormat::Rgb24, 100, 2).validate(), std::domain_error);
+}
+TEST(RecorderTest, FrameViewValidation)
+{
+	std::vector<uint8_t> Y(64 * 64), U(32 * 32), V(32 * 32);
+
+	// Plane too small for the requested size
+	EXPECT_THROW(FrameView::yuv420p(Y, 64, U, 32, V, 32, 64, 66).validate(), std::domain_error);
+
+	// Stride smaller than a row
+	EXPECT_THROW(FrameView::yuv420p(Y, 60, U, 32, V, 32, 64, 64).validate(), std::domain_error);
+
+	// Packed layouts only
+	EXPECT_THROW(FrameView::packed(Y, 64, PixelFormat::Yuv420P, 64, 64), std::domain_error);
+
+	// The span based overloads are validated as well
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.open(std::make_shared<NullSink>(), 64, 64, 25);
+	EXPECT_THROW(rec.write(gsl::span<const uint8_t>{ Y.data(), 64 * 32 }, U, V), std::domain_error);
+	EXPECT_THROW(rec.write(Y, PixelFormat::Bgra, 64, 64), std::domain_error);
+	EXPECT_TRUE(rec.write(Y, U, V));
+}
@@ -0,0 +1,102 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vcl/graphics/recorder/ladder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	std::vector<LadderRung> rungs(const char* name)
+	{
+		std::vector<LadderRung> ladder(3);
+		const unsigned int sizes[] = { 256, 128, 64 };
+		for (size_t r = 0; r < ladder.size(); r++)
+		{
+			ladder[r].width = sizes[r];
+			ladder[r].height = sizes[r];
+			ladder[r].url = std::string{ name } + "_" + std::to_string(sizes[r]) + ".mkv";
+		}
+		return ladder;
+	}
+}
+
+TEST(RecorderTest, LadderSequence)
+{
+	std::vector<std::array<uint8_t, 4>> bgra(512 * 512);
+
+	Ladder ladder{ OutputFormat::Mkv, CodecType::Ffv1, rungs("ladder") };
+	ladder.open(25);
+	for (int i = 0; i < 10; i++)
+	{
+		for (auto& pixel : bgra)
+			pixel = { static_cast<uint8_t>(i * 25), 128, 64, 255 };
+		EXPECT_TRUE(ladder.write(FrameView::packed({ bgra.data()->data(), static_cast<std::ptrdiff_t>(4 * bgra.size()) }, 4 * 512, PixelFormat::Bgra, 512, 512)));
+	}
+	ladder.close();
+
+	const auto stats = ladder.stats();
+	ASSERT_EQ(stats.size(), 3u);
+	for (size_t r = 0; r < stats.size(); r++)
+	{
+		EXPECT_EQ(stats[r].frames, 10u);
+		EXPECT_GT(stats[r].framesPerSecond(), 0.0);
+		EXPECT_EQ(ladder.recorder(r).stats().packets, 10u);
+	}
+	EXPECT_EQ(stats[1].width, 128u);
+}
+TEST(RecorderTest, LadderSingleThread)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Ladder ladder{ OutputFormat::Mkv, CodecType::Ffv1, rungs("ladder_single") };
+	ladder.setThreads(0);
+	ladder.open(25);
+	EXPECT_THROW(ladder.setThreads(2), std::runtime_error);
+	for (int i = 0; i < 5; i++)
+		EXPECT_TRUE(ladder.write(FrameView::yuv420p(Y, 256, U, 128, V, 128, 256, 256)));
+	ladder.close();
+
+	for (const auto& rung : ladder.stats())
+		EXPECT_EQ(rung.frames, 5u);
+}
+TEST(RecorderTest, LadderValidation)
+{
+	EXPECT_THROW(Ladder(OutputFormat::Mkv, CodecType::Ffv1, {}), std::domain_error);
+
+	auto increasing = rungs("ladder_invalid");
+	std::swap(increasing[0], increasing[1]);
+	EXPECT_THROW(Ladder(OutputFormat::Mkv, CodecType::Ffv1, increasing), std::domain_error);
+
+	auto odd = rungs("ladder_invalid");
+	odd[2].width = 63;
+	EXPECT_THROW(Ladder(OutputFormat::Mkv, CodecType::Ffv1, odd), std::domain_error);
+}
@@ -0,0 +1,150 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+
+#include "testhelpers.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	void writeFrames(Recorder& rec, int frames)
+	{
+		std::vector<uint8_t> Y(256 * 256, 255);
+		std::vector<uint8_t> U(128 * 128, 0);
+		std::vector<uint8_t> V(128 * 128, 0);
+
+		for (int i = 0; i < frames; i++)
+		{
+			std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i));
+			EXPECT_TRUE(rec.write(Y, U, V));
+		}
+	}
+}
+
+TEST(RecorderTest, ReplayKeepsDuration)
+{
+	ReplayOptions replay;
+	replay.duration = std::chrono::seconds(1);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.open(replay, 256, 256, 25);
+	writeFrames(rec, 100);
+
+	// Intra-only coding allows evicting single frames. At least one second is kept.
+	const size_t packets = rec.dumpReplay("replay_duration.mkv", OutputFormat::Mkv);
+	EXPECT_GE(packets, 25u);
+	EXPECT_LE(packets, 26u);
+	EXPECT_TRUE(std::ifstream{ "replay_duration.mkv" }.good());
+	rec.close();
+
+	// The packets stay available after closing and can be written to other containers
+	EXPECT_EQ(packets, rec.dumpReplay("replay_duration.avi", OutputFormat::Avi));
+}
+TEST(RecorderTest, ReplayEvictsWholeGops)
+{
+	if (!hasEncoder(CodecType::H264, "libx264"))
+		GTEST_SKIP() << "libx264 is not available";
+
+	EncoderSettings settings{ EncoderProfile::Realtime };
+	settings.gop_size = 10;
+	settings.max_b_frames = 0;
+
+	ReplayOptions replay;
+	replay.duration = std::chrono::seconds(1);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264, "libx264" };
+	rec.setEncoderSettings(settings);
+	rec.open(replay, 256, 256, 25);
+	writeFrames(rec, 100);
+	rec.close();
+
+	// One second are 25 frames, requiring the last three GOPs
+	EXPECT_EQ(30u, rec.dumpReplay("replay_gops.mp4", OutputFormat::Mp4));
+}
+TEST(RecorderTest, ReplayByteBudget)
+{
+	ReplayOptions replay;
+	replay.max_bytes = 1;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.open(replay, 256, 256, 25);
+	writeFrames(rec, 10);
+	rec.close();
+
+	// The newest GOP is kept even if it exceeds the budget
+	EXPECT_EQ(1u, rec.dumpReplay("replay_budget.mkv", OutputFormat::Mkv));
+}
+TEST(RecorderTest, ReplayRequiresReplayMode)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_THROW(rec.dumpReplay("replay_none.mkv", OutputFormat::Mkv), std::runtime_error);
+
+	ReplayOptions replay;
+	rec.open(replay, 256, 256, 25);
+	writeFrames(rec, 1);
+
+	// MP4 cannot store FFV1
+	EXPECT_THROW(rec.dumpReplay("replay_none.mp4", OutputFormat::Mp4), std::domain_error);
+	rec.close();
+}
+TEST(RecorderTest, ReplayPackets)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	std::vector<AVPacket*> packets;
+	EXPECT_THROW(rec.replayPackets(packets), std::runtime_error);
+
+	ReplayOptions replay;
+	replay.duration = std::chrono::seconds(1);
+	rec.open(replay, 256, 256, 25);
+	writeFrames(rec, 5);
+	rec.close();
+
+	// The packets are stored in the time base of the stream
+	rec.replayPackets(packets);
+	ASSERT_EQ(5u, packets.size());
+	const TimeBase time_base = rec.timeBase();
+	EXPECT_EQ(4, av_rescale_q(packets.back()->pts, { time_base.num, time_base.den }, { 1, 25 }));
+	for (auto& pkt : packets)
+		av_packet_free(&pkt);
+
+	AVCodecParameters* par = avcodec_parameters_alloc();
+	rec.streamParameters(par);
+	EXPECT_EQ(AV_CODEC_ID_FFV1, par->codec_id);
+	EXPECT_EQ(256, par->width);
+	EXPECT_EQ(256, par->height);
+	avcodec_parameters_free(&par);
+}
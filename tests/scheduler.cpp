@@ -0,0 +1,112 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/scheduler.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, SchedulerStrandOrder)
+{
+	Scheduler scheduler{ 4 };
+
+	std::vector<std::shared_ptr<Strand>> strands;
+	std::vector<std::vector<int>> executed(16);
+	for (size_t s = 0; s < executed.size(); s++)
+		strands.emplace_back(scheduler.createStrand());
+
+	for (int t = 0; t < 100; t++)
+	{
+		for (size_t s = 0; s < strands.size(); s++)
+		{
+			auto order = &executed[s];
+			strands[s]->post([order, t]() { order->push_back(t); });
+		}
+	}
+	for (auto& strand : strands)
+		strand->drain();
+
+	// The tasks of a strand are executed one after the other in order
+	for (const auto& order : executed)
+	{
+		ASSERT_EQ(order.size(), 100u);
+		for (int t = 0; t < 100; t++)
+			EXPECT_EQ(order[t], t);
+	}
+
+	const auto stats = scheduler.stats();
+	EXPECT_EQ(stats.workers, 4u);
+	EXPECT_EQ(stats.tasks, 1600u);
+}
+TEST(RecorderTest, SchedulerPostFromTask)
+{
+	Scheduler scheduler{ 2 };
+	auto first = scheduler.createStrand();
+	auto second = scheduler.createStrand();
+
+	std::atomic<int> count{ 0 };
+	for (int t = 0; t < 100; t++)
+		first->post([second, &count]() { second->post([&count]() { count++; }); });
+	first->drain();
+	second->drain();
+
+	EXPECT_EQ(count, 100);
+}
+TEST(RecorderTest, SchedulerSharedByRecorders)
+{
+	std::vector<uint8_t> Y(128 * 128, 255);
+	std::vector<uint8_t> U(64 * 64, 0);
+	std::vector<uint8_t> V(64 * 64, 0);
+
+	auto scheduler = std::make_shared<Scheduler>(2);
+	std::vector<std::unique_ptr<Recorder>> recorders;
+	for (int r = 0; r < 8; r++)
+	{
+		recorders.emplace_back(std::make_unique<Recorder>(OutputFormat::Mkv, CodecType::Ffv1));
+		recorders.back()->setAsyncEncoding(true, 2);
+		recorders.back()->setScheduler(scheduler);
+		recorders.back()->open(std::make_shared<NullSink>(), 128, 128, 25);
+	}
+	EXPECT_THROW(recorders.front()->setScheduler(nullptr), std::runtime_error);
+
+	for (int i = 0; i < 20; i++)
+	{
+		std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * 10));
+		for (auto& rec : recorders)
+			EXPECT_TRUE(rec->write(Y, U, V));
+	}
+	for (auto& rec : recorders)
+	{
+		rec->close();
+		EXPECT_EQ(rec->stats().packets, 20u);
+	}
+
+	EXPECT_GE(scheduler->stats().tasks, 8u * 20u);
+}
@@ -0,0 +1,127 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	bool fileExists(const std::string& path)
+	{
+		std::ifstream file{ path };
+		return file.good();
+	}
+
+	//! Record a sequence of frames into segments
+	//! \returns the names of the finalized segments
+	std::vector<std::string> recordSegments(SegmentOptions segments, int frames)
+	{
+		std::vector<uint8_t> Y(256 * 256, 255);
+		std::vector<uint8_t> U(128 * 128, 0);
+		std::vector<uint8_t> V(128 * 128, 0);
+
+		std::vector<std::string> finalized;
+		segments.on_finalized = [&finalized](const std::string& path, unsigned int index)
+		{
+			EXPECT_EQ(finalized.size(), index);
+			finalized.push_back(path);
+		};
+
+		// FFV1 is intra-only, thus every frame can start a segment
+		Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+		rec.open(segments, 256, 256, 25);
+		for (int i = 0; i < frames; i++)
+		{
+			std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i));
+			EXPECT_TRUE(rec.write(Y, U, V));
+		}
+		rec.close();
+
+		EXPECT_EQ(static_cast<uint64_t>(frames), rec.stats().packets);
+		return finalized;
+	}
+}
+
+TEST(RecorderTest, SegmentsByDuration)
+{
+	SegmentOptions segments;
+	segments.pattern = "segment_duration_%05d.mkv";
+	segments.duration = std::chrono::seconds(1);
+
+	// 100 frames at 25 frames per second
+	const auto finalized = recordSegments(segments, 100);
+	ASSERT_EQ(4u, finalized.size());
+	EXPECT_EQ("segment_duration_00000.mkv", finalized[0]);
+	EXPECT_EQ("segment_duration_00003.mkv", finalized[3]);
+	for (const auto& path : finalized)
+		EXPECT_TRUE(fileExists(path)) << path;
+}
+TEST(RecorderTest, SegmentsBySize)
+{
+	SegmentOptions segments;
+	segments.pattern = "segment_size_%d.mkv";
+	segments.max_bytes = 1;
+
+	// Every segment is full after its first frame
+	const auto finalized = recordSegments(segments, 5);
+	ASSERT_EQ(5u, finalized.size());
+	EXPECT_EQ("segment_size_4.mkv", finalized[4]);
+}
+TEST(RecorderTest, SegmentsAsync)
+{
+	SegmentOptions segments;
+	segments.pattern = "segment_async_%05d.mkv";
+	segments.duration = std::chrono::milliseconds(400);
+
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	unsigned int count = 0;
+	segments.on_finalized = [&count](const std::string&, unsigned int) { count++; };
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setAsyncEncoding(true);
+	rec.open(segments, 256, 256, 25);
+	for (int i = 0; i < 50; i++)
+		EXPECT_TRUE(rec.write(Y, U, V));
+	rec.close();
+
+	// A new segment every 10 frames
+	EXPECT_EQ(5u, count);
+}
+TEST(RecorderTest, SegmentPatternRequiresIndex)
+{
+	SegmentOptions segments;
+	segments.pattern = "segment.mkv";
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_THROW(rec.open(segments, 256, 256, 25), std::domain_error);
+}
@@ -0,0 +1,176 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#	include <unistd.h>
+#endif
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	void recordSequence(Recorder& rec, std::shared_ptr<OutputSink> sink)
+	{
+		std::vector<uint8_t> Y(256 * 256, 255);
+		std::vector<uint8_t> U(128 * 128, 0);
+		std::vector<uint8_t> V(128 * 128, 0);
+
+		rec.open(std::move(sink), 256, 256, 25);
+		for (int i = 0; i < 10; i++)
+		{
+			std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(i * 25));
+			EXPECT_TRUE(rec.write(Y, U, V));
+		}
+		rec.close();
+	}
+
+	bool isMatroska(const std::vector<uint8_t>& data)
+	{
+		const uint8_t ebml[] = { 0x1a, 0x45, 0xdf, 0xa3 };
+		return data.size() > sizeof(ebml) && std::memcmp(data.data(), ebml, sizeof(ebml)) == 0;
+	}
+}
+
+TEST(RecorderTest, MemorySink)
+{
+	auto sink = std::make_shared<MemorySink>();
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	recordSequence(rec, sink);
+
+	EXPECT_TRUE(isMatroska(sink->data()));
+	EXPECT_EQ(sink->size(), static_cast<int64_t>(sink->data().size()));
+
+	const auto data = sink->release();
+	EXPECT_FALSE(data.empty());
+	EXPECT_TRUE(sink->data().empty());
+}
+TEST(RecorderTest, MemorySinkOverwrites)
+{
+	MemorySink sink;
+	const uint8_t first[] = { 1, 2, 3, 4 };
+	const uint8_t second[] = { 5, 6 };
+
+	EXPECT_TRUE(sink.write(first, sizeof(first)));
+	EXPECT_EQ(1, sink.seek(1, SEEK_SET));
+	EXPECT_TRUE(sink.write(second, sizeof(second)));
+	EXPECT_EQ(6, sink.seek(2, SEEK_END));
+	EXPECT_TRUE(sink.write(second, sizeof(second)));
+
+	const std::vector<uint8_t> expected = { 1, 5, 6, 4, 0, 0, 5, 6 };
+	EXPECT_EQ(expected, sink.data());
+}
+TEST(RecorderTest, CallbackSinkAppendOnly)
+{
+	std::vector<uint8_t> data;
+	auto sink = std::make_shared<CallbackSink>([&data](const uint8_t* buf, size_t size)
+	{
+		data.insert(data.end(), buf, buf + size);
+		return true;
+	});
+	EXPECT_FALSE(sink->isSeekable());
+	EXPECT_EQ(-1, sink->seek(0, SEEK_SET));
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	recordSequence(rec, sink);
+
+	EXPECT_TRUE(isMatroska(data));
+	EXPECT_EQ(sink->size(), static_cast<int64_t>(data.size()));
+}
+TEST(RecorderTest, SinkCloseErrorIsReported)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	bool failing = false;
+	auto sink = std::make_shared<CallbackSink>([&failing](const uint8_t*, size_t)
+	{
+		return !failing;
+	});
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.open(sink, 256, 256, 25);
+	EXPECT_TRUE(rec.write(Y, U, V));
+
+	// The trailer and the buffered data cannot be written
+	failing = true;
+	EXPECT_FALSE(rec.close());
+}
+TEST(RecorderTest, SinkCloseNotifiesSink)
+{
+	struct ClosingSink : NullSink
+	{
+		bool close() override
+		{
+			closed++;
+			return false;
+		}
+
+		int closed{0};
+	};
+	auto sink = std::make_shared<ClosingSink>();
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.open(sink, 256, 256, 25);
+	EXPECT_FALSE(rec.close());
+	EXPECT_EQ(1, sink->closed);
+}
+
+#ifndef _WIN32
+TEST(RecorderTest, FileDescriptorSinkPipe)
+{
+	int fds[2];
+	ASSERT_EQ(0, pipe(fds));
+
+	// Drain the pipe while recording
+	std::vector<uint8_t> data;
+	std::thread reader{ [&data, fd = fds[0]]()
+	{
+		uint8_t buf[4096];
+		ssize_t read_bytes = 0;
+		while ((read_bytes = read(fd, buf, sizeof(buf))) > 0)
+			data.insert(data.end(), buf, buf + read_bytes);
+		close(fd);
+	} };
+
+	auto sink = std::make_shared<FileDescriptorSink>(fds[1], true);
+	EXPECT_FALSE(sink->isSeekable());
+
+	// The recorder releases the sink on close, closing the pipe
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	recordSequence(rec, std::move(sink));
+	reader.join();
+
+	EXPECT_TRUE(isMatroska(data));
+}
+#endif
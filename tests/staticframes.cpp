@@ -0,0 +1,110 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+#include <vcl/graphics/recorder/staticframedetector.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, StaticFrameDetectorPaddedRows)
+{
+	// Rows of 3 pixels padded to 12 bytes
+	std::vector<uint8_t> bgr(12 * 2, 0);
+	const auto view = FrameView::packed(bgr, 12, PixelFormat::Bgr24, 3, 2);
+
+	StaticFrameDetector detector;
+	EXPECT_FALSE(detector.isUnchanged(view));
+	EXPECT_TRUE(detector.isUnchanged(view));
+
+	// The padding is ignored
+	bgr[10] = 1;
+	EXPECT_TRUE(detector.isUnchanged(view));
+
+	bgr[13] = 1;
+	EXPECT_FALSE(detector.isUnchanged(view));
+	EXPECT_TRUE(detector.isUnchanged(view));
+
+	// The copy is tightly packed
+	const auto previous = detector.previous();
+	EXPECT_EQ(9, previous.strides[0]);
+	EXPECT_EQ(1, previous.planes[0][10]);
+
+	detector.reset();
+	EXPECT_FALSE(detector.isUnchanged(view));
+}
+TEST(RecorderTest, StaticFrameDetectorLayoutChange)
+{
+	std::vector<uint8_t> Y(16 * 16, 0);
+	std::vector<uint8_t> UV(8 * 8 * 2, 128);
+
+	StaticFrameDetector detector;
+	EXPECT_FALSE(detector.isUnchanged(FrameView::nv12(Y, 16, UV, 16, 16, 16)));
+	EXPECT_TRUE(detector.isUnchanged(FrameView::nv12(Y, 16, UV, 16, 16, 16)));
+	EXPECT_FALSE(detector.isUnchanged(FrameView::nv12(Y, 16, UV, 16, 16, 8)));
+}
+TEST(RecorderTest, SkipStaticFrames)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setStaticFrameDetection(true);
+	EXPECT_TRUE(rec.isStaticFrameDetection());
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+
+	// Two distinct images, each repeated
+	for (int i = 0; i < 5; i++)
+		EXPECT_TRUE(rec.write(Y, U, V));
+	std::fill(std::begin(V), std::end(V), static_cast<uint8_t>(128));
+	for (int i = 0; i < 5; i++)
+		EXPECT_TRUE(rec.write(Y, U, V));
+	rec.close();
+
+	// The last image is repeated when closing to keep the duration
+	const auto stats = rec.stats();
+	EXPECT_EQ(8u, stats.skipped_frames);
+	EXPECT_EQ(3u, stats.packets);
+}
+TEST(RecorderTest, SkipStaticFramesLimit)
+{
+	std::vector<uint8_t> Y(256 * 256, 255);
+	std::vector<uint8_t> U(128 * 128, 0);
+	std::vector<uint8_t> V(128 * 128, 0);
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setStaticFrameDetection(true, 3);
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+	for (int i = 0; i < 10; i++)
+		EXPECT_TRUE(rec.write(Y, U, V));
+	rec.close();
+
+	// Images 0, 4 and 8 are encoded, as well as the last one
+	const auto stats = rec.stats();
+	EXPECT_EQ(7u, stats.skipped_frames);
+	EXPECT_EQ(4u, stats.packets);
+}
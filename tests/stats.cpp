@@ -0,0 +1,102 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <chrono>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, LatencyHistogramPercentiles)
+{
+	LatencyHistogram histogram;
+	for (int i = 1; i <= 1000; i++)
+		histogram.record(std::chrono::microseconds{ i });
+
+	const auto stats = histogram.summary();
+	EXPECT_EQ(1000u, stats.count);
+	EXPECT_EQ(std::chrono::microseconds{ 1000 }, stats.max);
+	EXPECT_EQ(std::chrono::microseconds{ 500500 }, stats.total);
+
+	// Buckets are accurate within 12.5%
+	EXPECT_NEAR(500000.0, static_cast<double>(stats.p50.count()), 500000.0 * 0.125);
+	EXPECT_NEAR(990000.0, static_cast<double>(stats.p99.count()), 990000.0 * 0.125);
+	EXPECT_LE(stats.p50, stats.p99);
+	EXPECT_LE(stats.p99, stats.max);
+
+	histogram.reset();
+	EXPECT_EQ(0u, histogram.summary().count);
+}
+TEST(RecorderTest, StatsDisabledByDefault)
+{
+	std::vector<std::array<uint8_t, 4>> bgra(256 * 256, { 0, 128, 255, 255 });
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	EXPECT_FALSE(rec.isStatsEnabled());
+	rec.open("stats_disabled.mkv", 256, 256, 25);
+	for (int i = 0; i < 10; i++)
+		EXPECT_TRUE(rec.write(bgra, 256, 256));
+	rec.close();
+
+	const auto stats = rec.stats();
+	for (const auto& stage : stats.stages)
+		EXPECT_EQ(0u, stage.count);
+
+	// Counting the output does not depend on the timers
+	EXPECT_GT(stats.packets, 0u);
+	EXPECT_GT(stats.bytes_written, 0u);
+}
+TEST(RecorderTest, StatsCollectStageTimings)
+{
+	std::vector<std::array<uint8_t, 4>> bgra(256 * 256, { 0, 128, 255, 255 });
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.setStatsEnabled(true);
+	rec.open("stats_enabled.mkv", 256, 256, 25);
+	for (int i = 0; i < 10; i++)
+		EXPECT_TRUE(rec.write(bgra, 256, 256));
+	rec.close();
+
+	const auto stats = rec.stats();
+	EXPECT_EQ(10u, stats.stage(Stage::Convert).count);
+
+	// Flushing the encoder sends an additional empty frame
+	EXPECT_EQ(11u, stats.stage(Stage::SendFrame).count);
+	EXPECT_GE(stats.stage(Stage::ReceivePacket).count, stats.packets);
+	EXPECT_EQ(stats.packets, stats.stage(Stage::WritePacket).count);
+	EXPECT_EQ(10u, stats.packets);
+
+	for (const auto& stage : stats.stages)
+	{
+		EXPECT_LE(stage.p50, stage.p99);
+		EXPECT_LE(stage.p99, stage.max);
+		EXPECT_LE(stage.max, stage.total);
+	}
+
+	rec.resetStats();
+	EXPECT_EQ(0u, rec.stats().packets);
+	EXPECT_EQ(0u, rec.stats().stage(Stage::Convert).count);
+}
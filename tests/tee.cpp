@@ -0,0 +1,138 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+#include "testhelpers.h"
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	void writeNoise(Recorder& rec, int frames)
+	{
+		// Noise cannot be compressed, thus the data is flushed to the outputs while writing
+		std::mt19937 rnd{ 42 };
+		std::uniform_int_distribution<int> dist{ 0, 255 };
+		std::vector<uint8_t> Y(256 * 256);
+		std::vector<uint8_t> U(128 * 128, 128);
+		std::vector<uint8_t> V(128 * 128, 128);
+		for (int i = 0; i < frames; i++)
+		{
+			for (auto& y : Y)
+				y = static_cast<uint8_t>(dist(rnd));
+			EXPECT_TRUE(rec.write(Y, U, V));
+		}
+	}
+
+	bool isMatroska(const std::vector<uint8_t>& data)
+	{
+		const uint8_t ebml[] = { 0x1a, 0x45, 0xdf, 0xa3 };
+		return data.size() > sizeof(ebml) && std::memcmp(data.data(), ebml, sizeof(ebml)) == 0;
+	}
+
+	bool isMp4(const std::vector<uint8_t>& data)
+	{
+		return data.size() > 8 && std::memcmp(data.data() + 4, "ftyp", 4) == 0;
+	}
+}
+
+TEST(RecorderTest, TeeOutputMkvMp4H264)
+{
+	if (!hasEncoder(CodecType::H264, "libx264"))
+		GTEST_SKIP() << "libx264 is not available";
+
+	auto mkv = std::make_shared<MemorySink>();
+	auto mp4 = std::make_shared<MemorySink>();
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	EXPECT_EQ(rec.addOutput(OutputFormat::Mp4, mp4), 0u);
+	EXPECT_EQ(rec.outputCount(), 1u);
+	rec.open(mkv, 256, 256, 25);
+	writeNoise(rec, 10);
+	rec.close();
+
+	EXPECT_TRUE(isMatroska(mkv->data()));
+	EXPECT_TRUE(isMp4(mp4->data()));
+	EXPECT_FALSE(rec.isOutputFailed(0));
+	EXPECT_EQ(rec.stats().failed_outputs, 0u);
+}
+TEST(RecorderTest, TeeOutputFile)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.addOutput(OutputFormat::Mkv, "tee_copy.mkv");
+	rec.setAsyncEncoding(true, 4);
+	rec.open("tee_main.mkv", 256, 256, 25);
+	writeNoise(rec, 10);
+	rec.close();
+
+	EXPECT_FALSE(rec.isOutputFailed(0));
+}
+TEST(RecorderTest, TeeOutputFailureIsIndependent)
+{
+	auto main = std::make_shared<MemorySink>();
+	auto healthy = std::make_shared<MemorySink>();
+	auto broken = std::make_shared<CallbackSink>([](const uint8_t*, size_t) { return false; });
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.addOutput(OutputFormat::Mkv, broken);
+	rec.addOutput(OutputFormat::Mkv, healthy);
+	rec.open(main, 256, 256, 25);
+	writeNoise(rec, 10);
+	rec.close();
+
+	EXPECT_TRUE(rec.isOutputFailed(0));
+	EXPECT_FALSE(rec.isOutputFailed(1));
+	EXPECT_EQ(rec.stats().failed_outputs, 1u);
+	EXPECT_EQ(rec.stats().packets, 10u);
+
+	// The intact outputs are complete
+	EXPECT_TRUE(isMatroska(main->data()));
+	EXPECT_TRUE(isMatroska(healthy->data()));
+}
+TEST(RecorderTest, TeeOutputValidation)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_THROW(rec.addOutput(OutputFormat::Mp4, "tee_ffv1.mp4"), std::domain_error);
+	EXPECT_THROW(rec.addOutput(OutputFormat::Mkv, std::shared_ptr<OutputSink>{}), std::domain_error);
+	EXPECT_THROW(rec.isOutputFailed(0), std::out_of_range);
+
+	rec.addOutput(OutputFormat::Mkv, "tee_locked.mkv");
+	EXPECT_THROW(rec.open(ReplayOptions{}, 256, 256, 25), std::runtime_error);
+
+	rec.open("tee_locked_main.mkv", 256, 256, 25);
+	EXPECT_THROW(rec.addOutput(OutputFormat::Mkv, "tee_other.mkv"), std::runtime_error);
+	EXPECT_THROW(rec.clearOutputs(), std::runtime_error);
+	rec.close();
+
+	rec.clearOutputs();
+	EXPECT_EQ(rec.outputCount(), 0u);
+}
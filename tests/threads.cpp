@@ -0,0 +1,89 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <vcl/graphics/recorder/recorder.h>
+
+#include "testhelpers.h"
+
+extern "C"
+{
+#include <libavcodec/avcodec.h>
+}
+
+using namespace Vcl::Graphics::Recorder;
+
+TEST(RecorderTest, EncoderThreadsConfiguration)
+{
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+
+	EncoderThreads cfg;
+	cfg.model = ThreadingModel::Slice;
+	cfg.count = 2;
+	cfg.affinity = { 0 };
+	rec.setEncoderThreads(cfg);
+
+	const auto requested = rec.encoderThreads();
+	EXPECT_EQ(ThreadingModel::Slice, requested.model);
+	EXPECT_EQ(2u, requested.count);
+	EXPECT_EQ(std::vector<unsigned int>{ 0 }, requested.affinity);
+
+	rec.open("threads.mkv", 256, 256, 25);
+
+	// libavcodec keeps slice threading for encoders supporting it and
+	// otherwise falls back to a single thread
+	const AVCodec* codec = avcodec_find_encoder_by_name(rec.encoderName());
+	ASSERT_NE(nullptr, codec);
+	const auto effective = rec.encoderThreads();
+	if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS)
+	{
+		EXPECT_EQ(ThreadingModel::Slice, effective.model);
+		EXPECT_EQ(2u, effective.count);
+	}
+	else
+	{
+		EXPECT_EQ(ThreadingModel::Auto, effective.model);
+		EXPECT_EQ(1u, effective.count);
+	}
+	EXPECT_EQ(std::vector<unsigned int>{ 0 }, effective.affinity);
+
+	EXPECT_THROW(rec.setEncoderThreads(cfg), std::runtime_error);
+}
+TEST(RecorderTest, EncoderThreadsFrameModelKept)
+{
+	if (!hasEncoder(CodecType::H264, "libx264"))
+		GTEST_SKIP() << "libx264 is not available";
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264, "libx264" };
+
+	EncoderThreads cfg;
+	cfg.model = ThreadingModel::Frame;
+	cfg.count = 2;
+	rec.setEncoderThreads(cfg);
+	rec.open("threads_frame.mkv", 256, 256, 25);
+
+	// libx264 manages its own threads and supports frame threading
+	const auto effective = rec.encoderThreads();
+	EXPECT_EQ(ThreadingModel::Frame, effective.model);
+	EXPECT_EQ(2u, effective.count);
+}
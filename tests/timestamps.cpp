@@ -0,0 +1,162 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+namespace
+{
+	struct TestImage
+	{
+		TestImage()
+		: Y(256 * 256, 255), U(128 * 128, 0), V(128 * 128, 0)
+		{
+		}
+
+		FrameView view() const
+		{
+			return FrameView::yuv420p(Y, 256, U, 128, V, 128, 256, 256);
+		}
+
+		std::vector<uint8_t> Y;
+		std::vector<uint8_t> U;
+		std::vector<uint8_t> V;
+	};
+}
+
+TEST(RecorderTest, ConstantTimingRepeatsAndDrops)
+{
+	const TestImage image;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	EXPECT_EQ(FrameTiming::Constant, rec.frameTiming());
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+
+	// Frame intervals of 40ms
+	EXPECT_TRUE(rec.write(image.view(), milliseconds(1000)));
+	EXPECT_TRUE(rec.write(image.view(), milliseconds(1040)));
+
+	// Same interval as the previous image
+	EXPECT_TRUE(rec.write(image.view(), milliseconds(1050)));
+
+	// Two intervals were missed
+	EXPECT_TRUE(rec.write(image.view(), milliseconds(1160)));
+	rec.close();
+
+	const auto stats = rec.stats();
+	EXPECT_EQ(1u, stats.dropped_frames);
+	EXPECT_EQ(2u, stats.duplicated_frames);
+	EXPECT_EQ(5u, stats.packets);
+}
+TEST(RecorderTest, ConstantTimingRepeatsPreviousImage)
+{
+	const TestImage first;
+	TestImage second;
+	second.Y[0] = 0;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setStaticFrameDetection(true);
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+
+	// The missed intervals repeat the first image, which is unchanged
+	EXPECT_TRUE(rec.write(first.view(), milliseconds(0)));
+	EXPECT_TRUE(rec.write(second.view(), milliseconds(120)));
+	rec.close();
+
+	const auto stats = rec.stats();
+	EXPECT_EQ(2u, stats.skipped_frames);
+	EXPECT_EQ(0u, stats.duplicated_frames);
+	EXPECT_EQ(2u, stats.packets);
+}
+TEST(RecorderTest, ConstantTimingRepeatsAsync)
+{
+	const TestImage image;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setAsyncEncoding(true, 2);
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+
+	// The repeated images are queued like any other image
+	EXPECT_TRUE(rec.write(image.view(), milliseconds(0)));
+	EXPECT_TRUE(rec.write(image.view(), milliseconds(400)));
+	rec.close();
+
+	const auto stats = rec.stats();
+	EXPECT_EQ(9u, stats.duplicated_frames);
+	EXPECT_EQ(11u, stats.packets);
+}
+TEST(RecorderTest, VariableTimingKeepsTimestamps)
+{
+	const TestImage image;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::Ffv1 };
+	rec.setFrameTiming(FrameTiming::Variable);
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+
+	EXPECT_TRUE(rec.write(image.view(), microseconds(0)));
+	EXPECT_TRUE(rec.write(image.view(), microseconds(10000)));
+	EXPECT_TRUE(rec.write(image.view(), microseconds(250000)));
+
+	// Time does not advance
+	EXPECT_TRUE(rec.write(image.view(), microseconds(250000)));
+
+	// Without timestamp, the image follows one frame interval later
+	EXPECT_TRUE(rec.write(image.view()));
+	rec.close();
+
+	const auto stats = rec.stats();
+	EXPECT_EQ(1u, stats.dropped_frames);
+	EXPECT_EQ(0u, stats.duplicated_frames);
+	EXPECT_EQ(4u, stats.packets);
+}
+TEST(RecorderTest, SteadyClockTimestamps)
+{
+	const TestImage image;
+
+	Recorder rec{ OutputFormat::Mp4, CodecType::H264 };
+	rec.setFrameTiming(FrameTiming::Variable);
+	rec.open(std::make_shared<MemorySink>(), 256, 256, 30);
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < 10; i++)
+		EXPECT_TRUE(rec.write(image.view(), start + milliseconds(i * i)));
+	rec.close();
+
+	EXPECT_EQ(0u, rec.stats().dropped_frames);
+	EXPECT_EQ(10u, rec.stats().packets);
+}
+TEST(RecorderTest, VariableTimingRequiresContainerSupport)
+{
+	Recorder rec{ OutputFormat::Avi, CodecType::Ffv1 };
+	rec.setFrameTiming(FrameTiming::Variable);
+	EXPECT_THROW(rec.open(std::make_shared<NullSink>(), 256, 256, 25), std::domain_error);
+}
@@ -0,0 +1,98 @@
+/* The VCL screen capture library is released under the MIT license.
+ * 
+ * Copyright(c) 2018 Basil Fierz
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files(the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions :
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+#include <gtest/gtest.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include <vcl/graphics/recorder/recorder.h>
+#include <vcl/graphics/recorder/sink.h>
+
+using namespace Vcl::Graphics::Recorder;
+
+namespace
+{
+	//! Record frames referencing a set of constant buffers
+	void recordWithRelease(Recorder& rec, int frames, std::atomic<int>& released)
+	{
+		const int w = 256, h = 256;
+		std::array<std::vector<uint8_t>, 4> buffers;
+		for (auto& buffer : buffers)
+			buffer.resize(w * h * 3 / 2, 128);
+
+		for (int i = 0; i < frames; i++)
+		{
+			auto& buffer = buffers[i % buffers.size()];
+			const gsl::span<const uint8_t> data{ buffer };
+			const auto view = FrameView::yuv420p
+			(
+				data.subspan(0, w * h), w,
+				data.subspan(w * h, w * h / 4), w / 2,
+				data.subspan(w * h * 5 / 4, w * h / 4), w / 2,
+				w, h
+			);
+			EXPECT_TRUE(rec.write(view, [&released]() { released++; }));
+		}
+	}
+}
+
+TEST(RecorderTest, ZeroCopyReleaseSync)
+{
+	std::atomic<int> released{ 0 };
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+	recordWithRelease(rec, 20, released);
+	EXPECT_LE(released, 20);
+	rec.close();
+
+	// Every buffer is returned exactly once
+	EXPECT_EQ(20, released);
+	EXPECT_EQ(20u, rec.stats().packets);
+}
+TEST(RecorderTest, ZeroCopyReleaseAsync)
+{
+	std::atomic<int> released{ 0 };
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.setAsyncEncoding(true, 4);
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+	recordWithRelease(rec, 20, released);
+	rec.close();
+
+	EXPECT_EQ(20, released);
+	EXPECT_EQ(20u, rec.stats().packets);
+}
+TEST(RecorderTest, ZeroCopyConvertedInputReleasedImmediately)
+{
+	std::vector<std::array<uint8_t, 4>> bgra(256 * 256, { 0, 128, 255, 255 });
+	const gsl::span<const uint8_t> data{ bgra.data()->data(), 4 * 256 * 256 };
+	int released = 0;
+
+	Recorder rec{ OutputFormat::Mkv, CodecType::H264 };
+	rec.open(std::make_shared<NullSink>(), 256, 256, 25);
+	EXPECT_TRUE(rec.write(FrameView::packed(data, 4 * 256, PixelFormat::Bgra, 256, 256), [&released]() { released++; }));
+	EXPECT_EQ(1, released);
+}